@@ -1,7 +1,7 @@
 #include "cube_app.hpp"
+#include "mipmap_builder.hpp"
 
 #include <array>
-#include <fstream>
 #include <glm/gtc/matrix_transform.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -32,106 +32,19 @@ namespace app
 		{ {
 			{0,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(CubeVertex,position)},
 			{1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(CubeVertex,color)},
-			{2,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(CubeVertex,uv)},
+			{2,0,VK_FORMAT_R32G32_SFLOAT,offsetof(CubeVertex,uv)},
 		} };
-		VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
-		pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-		pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexInputBindingDescription;
-		pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexInputAttributeDescriptions.size();
-		pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInputAttributeDescriptions.data();
-
-		const auto colorWriteAll =
-			VK_COLOR_COMPONENT_R_BIT |
-			VK_COLOR_COMPONENT_G_BIT |
-			VK_COLOR_COMPONENT_B_BIT |
-			VK_COLOR_COMPONENT_A_BIT;
-		VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-		pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
-		pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-		pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-		pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		pipelineColorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
-		pipelineColorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
-		pipelineColorBlendAttachmentState.colorWriteMask = colorWriteAll;
-		VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
-		pipelineColorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		pipelineColorBlendStateCreateInfo.attachmentCount = 1;
-		pipelineColorBlendStateCreateInfo.pAttachments = &pipelineColorBlendAttachmentState;
-
-		VkViewport viewport
-		{
-			0.0f, static_cast<float>(m_swapchainExtent.height),
-			static_cast<float>(m_swapchainExtent.width), -1.0f * m_swapchainExtent.height,
-			0.0f,1.0f
-		};
 
-		VkRect2D scissor =
-		{
-			{0,0},
-			m_swapchainExtent
-		};
-		VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{};
-		pipelineViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		pipelineViewportStateCreateInfo.viewportCount = 1;
-		pipelineViewportStateCreateInfo.pViewports = &viewport;
-		pipelineViewportStateCreateInfo.scissorCount = 1;
-		pipelineViewportStateCreateInfo.pScissors = &scissor;
-
-		VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
-		pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-		VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
-		pipelineRasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		pipelineRasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-		pipelineRasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
-		pipelineRasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		pipelineRasterizationStateCreateInfo.lineWidth = 1.0f;
-
-		VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{};
-		pipelineMultisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		pipelineMultisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-		VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{};
-		pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-		pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
-
-		std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos
-		{
-			loadShaderModule("source/cube.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
-			loadShaderModule("source/cube.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
-		};
+		m_pipelineLayout = SpirvReflection::createPipelineLayout(m_device, m_shaderReflection, { m_descriptorSetLayout });
 
-		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCreateInfo.setLayoutCount = 1;
-		pipelineLayoutCreateInfo.pSetLayouts = &m_descriptorSetLayout;
-		vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
-
-		VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
-		graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		graphicsPipelineCreateInfo.stageCount = pipelineShaderStageCreateInfos.size();
-		graphicsPipelineCreateInfo.pStages = pipelineShaderStageCreateInfos.data();
-		graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
-		graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
-		graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
-		graphicsPipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
-		graphicsPipelineCreateInfo.pMultisampleState = &pipelineMultisampleStateCreateInfo;
-		graphicsPipelineCreateInfo.pViewportState = &pipelineViewportStateCreateInfo;
-		graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
-		graphicsPipelineCreateInfo.renderPass = m_renderPass;
-		graphicsPipelineCreateInfo.layout = m_pipelineLayout;
-		vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &m_pipeline);
-
-		for (const auto& shaderStage : pipelineShaderStageCreateInfos)
-		{
-			vkDestroyShaderModule(m_device, shaderStage.module, nullptr);
-		}
+		PipelineState pipelineState{};
+		pipelineState.vertexShader = "source/cube.vert.spv";
+		pipelineState.fragmentShader = "source/cube.frag.spv";
+		pipelineState.vertexBindings = { vertexInputBindingDescription };
+		pipelineState.vertexAttributes.assign(vertexInputAttributeDescriptions.begin(), vertexInputAttributeDescriptions.end());
+		pipelineState.layout = m_pipelineLayout;
+		pipelineState.renderPass = m_renderPass;
+		m_pipeline = m_pipelineRegistry.getPipeline(pipelineState);
 	}
 
 	void CubeApp::cleanup()
@@ -148,7 +61,6 @@ namespace app
 		vkFreeMemory(m_device, m_textureObject.deviceMemory, nullptr);
 
 		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-		vkDestroyPipeline(m_device, m_pipeline, nullptr);
 
 		vkFreeMemory(m_device, m_vertexBuffer.deviceMemory, nullptr);
 		vkFreeMemory(m_device, m_indexBuffer.deviceMemory, nullptr);
@@ -164,7 +76,7 @@ namespace app
 		ShaderParameters shaderParameters{};
 		shaderParameters.matrixWorld = glm::rotate(glm::identity<glm::mat4>(), glm::radians(45.0f), glm::vec3(0, 1, 0));
 		shaderParameters.matrixView = glm::lookAtRH(glm::vec3(0.0f, 3.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		shaderParameters.matrixProjection = glm::perspective(glm::radians(60.0f), 640.0f / 480, 0.01f, 100.0f);
+		shaderParameters.matrixProjection = glm::perspective(glm::radians(60.0f), static_cast<float>(m_swapchainExtent.width) / m_swapchainExtent.height, 0.01f, 100.0f);
 
 		{
 			auto memory = m_uniformBuffers[m_imageIndex].deviceMemory;
@@ -190,6 +102,29 @@ namespace app
 		vkCmdDrawIndexed(command, m_indexCount, 1, 0, 0, 0);
 	}
 
+	void CubeApp::onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced)
+	{
+		auto found = replaced.find(m_pipeline);
+		if (found != replaced.end())
+		{
+			m_pipeline = found->second;
+		}
+	}
+
+	void CubeApp::onSwapchainImageCountChanged()
+	{
+		for (auto& uniformBuffer : m_uniformBuffers)
+		{
+			vkDestroyBuffer(m_device, uniformBuffer.buffer, nullptr);
+			vkFreeMemory(m_device, uniformBuffer.deviceMemory, nullptr);
+		}
+		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+
+		prepareUniformBuffers();
+		prepareDescriptorPool();
+		prepareDescriptorSet();
+	}
+
 	void CubeApp::makeCubeGeometry()
 	{
 		using namespace glm;
@@ -295,39 +230,25 @@ namespace app
 
 	void CubeApp::prepareDescriptorSetLayout()
 	{
-		std::vector<VkDescriptorSetLayoutBinding>bindings;
-		VkDescriptorSetLayoutBinding bindingUniformBuffer{}, bindingTexture{};
-		bindingUniformBuffer.binding = 0;
-		bindingUniformBuffer.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		bindingUniformBuffer.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		bindingUniformBuffer.descriptorCount = 1;
-		bindings.emplace_back(std::move(bindingUniformBuffer));
-
-		bindingTexture.binding = 1;
-		bindingTexture.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		bindingTexture.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		bindingTexture.descriptorCount = 1;
-		bindings.emplace_back(std::move(bindingTexture));
-
-		VkDescriptorSetLayoutCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		createInfo.bindingCount = bindings.size();
-		createInfo.pBindings = bindings.data();
-		vkCreateDescriptorSetLayout(m_device, &createInfo, nullptr, &m_descriptorSetLayout);
+		m_shaderReflection = reflectShaders({ "source/cube.vert.spv", "source/cube.frag.spv" });
+
+		const auto setLayouts = SpirvReflection::createDescriptorSetLayouts(m_device, m_shaderReflection);
+		if (setLayouts.size() != 1)
+		{
+			DebugBreak();
+			return;
+		}
+		m_descriptorSetLayout = setLayouts.front();
 	}
 
 	void CubeApp::prepareDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 2> descriptorPoolSize;
-		descriptorPoolSize[0].descriptorCount = m_swapchainImageViews.size();
-		descriptorPoolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorPoolSize[1].descriptorCount = m_swapchainImageViews.size();
-		descriptorPoolSize[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		const auto descriptorPoolSize = SpirvReflection::getDescriptorPoolSizes(m_shaderReflection, 0, static_cast<uint32_t>(m_swapchainImageViews.size()));
 
 		VkDescriptorPoolCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		createInfo.maxSets = m_swapchainImageViews.size();
-		createInfo.poolSizeCount = descriptorPoolSize.size();
+		createInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSize.size());
 		createInfo.pPoolSizes = descriptorPoolSize.data();
 		vkCreateDescriptorPool(m_device, &createInfo, nullptr, &m_descriptorPool);
 	}
@@ -418,8 +339,17 @@ namespace app
 		TextureObject textureObject{};
 
 		int width = 0, height = 0, channels = 0;
-		auto* const image = stbi_load(filename.data(), &width, &height, &channels, 0);
+		auto* const image = stbi_load(filename.data(), &width, &height, &channels, STBI_rgb_alpha);
 		auto format = VK_FORMAT_R8G8B8A8_UNORM;
+		const auto mipLevels = MipmapBuilder::getLevelCount(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+		const auto useBlit = isLinearBlitSupported(format);
+
+		//NOTE:Without linear blits the whole chain is built up front and staged together.
+		MipChain chain{};
+		if (!useBlit)
+		{
+			chain = MipmapBuilder::build(static_cast<uint32_t>(width), static_cast<uint32_t>(height), image);
+		}
 
 		{
 			VkImageCreateInfo imageCreateInfo{};
@@ -428,9 +358,9 @@ namespace app
 			imageCreateInfo.format = format;
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
 			imageCreateInfo.arrayLayers = 1;
-			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.mipLevels = mipLevels;
 			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			vkCreateImage(m_device, &imageCreateInfo, nullptr, &textureObject.image);
 
 			VkMemoryRequirements memoryRequirements{};
@@ -444,17 +374,34 @@ namespace app
 		}
 
 		{
-			uint32_t imageSize = width * height * sizeof(uint32_t);
+			uint32_t imageSize = useBlit ? width * height * sizeof(uint32_t) : static_cast<uint32_t>(chain.pixels.size());
 			stagingBuffer = createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 			void* data = nullptr;
 			vkMapMemory(m_device, stagingBuffer.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data);
-			memcpy(data, image, imageSize);
+			memcpy(data, useBlit ? image : chain.pixels.data(), imageSize);
 			vkUnmapMemory(m_device, stagingBuffer.deviceMemory);
 		}
 
-		VkBufferImageCopy copyRegion{};
-		copyRegion.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
-		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,0,0,1 };
+		std::vector<VkBufferImageCopy> copyRegions;
+		if (useBlit)
+		{
+			VkBufferImageCopy copyRegion{};
+			copyRegion.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+			copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,0,0,1 };
+			copyRegions.push_back(copyRegion);
+		}
+		else
+		{
+			for (auto level = 0u; level < chain.levels.size(); ++level)
+			{
+				const auto& mipLevel = chain.levels[level];
+				VkBufferImageCopy copyRegion{};
+				copyRegion.bufferOffset = mipLevel.offset;
+				copyRegion.imageExtent = { mipLevel.width, mipLevel.height, 1 };
+				copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,level,0,1 };
+				copyRegions.push_back(copyRegion);
+			}
+		}
 		VkCommandBuffer commandBuffer = nullptr;
 		{
 			VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
@@ -468,10 +415,17 @@ namespace app
 		VkCommandBufferBeginInfo commandBufferBeginInfo{};
 		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
-		setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+		setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
 
-		setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		if (useBlit)
+		{
+			generateMipmaps(commandBuffer, textureObject.image, static_cast<uint32_t>(width), static_cast<uint32_t>(height), mipLevels);
+		}
+		else
+		{
+			setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+		}
 		vkEndCommandBuffer(commandBuffer);
 
 		VkSubmitInfo submitInfo{};
@@ -492,7 +446,7 @@ namespace app
 				VK_COMPONENT_SWIZZLE_A,
 			};
 			imageViewCreateInfo.subresourceRange = {
-				VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1
+				VK_IMAGE_ASPECT_COLOR_BIT,0,mipLevels,0,1
 			};
 			vkCreateImageView(m_device, &imageViewCreateInfo, nullptr, &textureObject.imageView);
 		}
@@ -517,13 +471,16 @@ namespace app
 		createInfo.magFilter = VK_FILTER_LINEAR;
 		createInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		createInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		createInfo.minLod = 0.0f;
+		createInfo.maxLod = VK_LOD_CLAMP_NONE;
 		createInfo.maxAnisotropy = 1.0f;
 		createInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 		vkCreateSampler(m_device, &createInfo, nullptr, &sampler);
 		return sampler;
 	}
 
-	void CubeApp::setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) const
+	void CubeApp::setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) const
 	{
 		VkImageMemoryBarrier imageMemoryBarrier{};
 		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -531,7 +488,7 @@ namespace app
 		imageMemoryBarrier.newLayout = newLayout;
 		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1 };
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,0,mipLevels,0,1 };
 		imageMemoryBarrier.image = image;
 
 		VkPipelineStageFlags srcStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
@@ -557,6 +514,7 @@ namespace app
 		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
 			imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
 		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
 			imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -578,37 +536,5 @@ namespace app
 		);
 	}
 
-	VkPipelineShaderStageCreateInfo CubeApp::loadShaderModule(std::string_view fileName, VkShaderStageFlagBits stage)
-	{
-		std::ifstream infile(fileName.data(), std::ios::binary);
-
-		if (!infile)
-		{
-			OutputDebugStringA(fileName.data());
-			OutputDebugStringA("file not found.\n");
-			DebugBreak();
-		}
-
-		std::vector<char>filedata;
-		filedata.resize(static_cast<uint32_t>(infile.seekg(0, std::ifstream::end).tellg()));
-		infile.seekg(0, std::ifstream::beg).read(filedata.data(), filedata.size());
-
-		VkShaderModule shaderModule = 0ull;
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = reinterpret_cast<uint32_t*>(filedata.data());
-		shaderModuleCreateInfo.codeSize = filedata.size();
-		vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &shaderModule);
-
-		VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
-		pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		pipelineShaderStageCreateInfo.stage = stage;
-		pipelineShaderStageCreateInfo.module = shaderModule;
-		pipelineShaderStageCreateInfo.pName = "main";
-
-		return pipelineShaderStageCreateInfo;
-
-	}
-
 }
 
@@ -52,6 +52,8 @@ namespace app
 		virtual void prepare() override;
 		virtual void cleanup() override;
 		virtual void makeCommand(VkCommandBuffer command) override;
+		virtual void onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced) override;
+		virtual void onSwapchainImageCountChanged() override;
 
 	private:
 		void makeCubeGeometry();
@@ -66,9 +68,7 @@ namespace app
 
 		VkSampler createSampler()const;
 
-		void setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) const;
-
-		VkPipelineShaderStageCreateInfo loadShaderModule(std::string_view fileName, VkShaderStageFlagBits stage);
+		void setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1) const;
 
 		BufferObject m_vertexBuffer{};
 		BufferObject m_indexBuffer{};
@@ -76,6 +76,8 @@ namespace app
 
 		std::vector<BufferObject>m_uniformBuffers;
 
+		//NOTE:cube.vert and cube.frag merged, the layouts and pool sizes come from it.
+		ShaderReflection m_shaderReflection;
 		VkDescriptorSetLayout m_descriptorSetLayout = 0ull;
 		VkDescriptorPool m_descriptorPool = 0ull;
 		std::vector<VkDescriptorSet> m_descriptorSet;
@@ -84,6 +86,7 @@ namespace app
 		VkSampler m_sampler = 0ull;
 
 		VkPipelineLayout m_pipelineLayout = 0ull;
+		//NOTE:Owned by m_pipelineRegistry.
 		VkPipeline m_pipeline = 0ull;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450
+layout(location=0) in vec4 inPosition;
+
+// The colour pass tests depth against what the depth prepass wrote, both must compute the same position bit for bit.
+invariant gl_Position;
+
+layout(binding=0) uniform Matrices
+{
+    mat4 world;
+    mat4 view;
+    mat4 projection;        
+};
+
+layout(push_constant) uniform MeshParameters
+{
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+// True for VertexFormat::Compact, positions are snorm16 relative to the mesh bounds.
+layout(constant_id=2) const bool DEQUANTIZE_POSITION = false;
+
+void main()
+{
+    vec3 position = DEQUANTIZE_POSITION ? positionOffset.xyz + inPosition.xyz * positionScale.xyz : inPosition.xyz;
+    mat4 projectionViewWorld = projection * view * world;
+    gl_Position = projectionViewWorld * vec4(position, 1.0);
+}
\ No newline at end of file
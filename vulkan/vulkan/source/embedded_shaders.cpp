@@ -0,0 +1,68 @@
+#include "embedded_shaders.hpp"
+
+#include <array>
+
+//NOTE:Every generated header declares the same "spirv" array, a namespace each keeps them apart.
+namespace app::spirv_triangle_vert
+{
+#include "triangle.vert.spv.h"
+}
+namespace app::spirv_triangle_frag
+{
+#include "triangle.frag.spv.h"
+}
+namespace app::spirv_cube_vert
+{
+#include "cube.vert.spv.h"
+}
+namespace app::spirv_cube_frag
+{
+#include "cube.frag.spv.h"
+}
+namespace app::spirv_model_vert
+{
+#include "model.vert.spv.h"
+}
+namespace app::spirv_depth_vert
+{
+#include "depth.vert.spv.h"
+}
+namespace app::spirv_material_frag
+{
+#include "material.frag.spv.h"
+}
+
+namespace app
+{
+	namespace
+	{
+		template<size_t N>
+		constexpr EmbeddedShader makeEmbeddedShader(const char* fileName, const uint32_t(&code)[N])
+		{
+			return { fileName, code, N };
+		}
+
+		const std::array<EmbeddedShader, 7> EMBEDDED_SHADERS
+		{ {
+			makeEmbeddedShader("source/triangle.vert.spv", spirv_triangle_vert::spirv),
+			makeEmbeddedShader("source/triangle.frag.spv", spirv_triangle_frag::spirv),
+			makeEmbeddedShader("source/cube.vert.spv", spirv_cube_vert::spirv),
+			makeEmbeddedShader("source/cube.frag.spv", spirv_cube_frag::spirv),
+			makeEmbeddedShader("source/model.vert.spv", spirv_model_vert::spirv),
+			makeEmbeddedShader("source/depth.vert.spv", spirv_depth_vert::spirv),
+			makeEmbeddedShader("source/material.frag.spv", spirv_material_frag::spirv),
+		} };
+	}
+
+	const EmbeddedShader* EmbeddedShaders::find(const std::string& fileName)
+	{
+		for (const auto& shader : EMBEDDED_SHADERS)
+		{
+			if (fileName == shader.fileName)
+			{
+				return &shader;
+			}
+		}
+		return nullptr;
+	}
+}
\ No newline at end of file
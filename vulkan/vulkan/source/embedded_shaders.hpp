@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace app
+{
+	//NOTE:SPIR-V compiled into the executable. Every shader's CustomBuild step writes "<shader>.spv.h"
+	//     next to the .spv with glslangValidator --vn, and embedded_shaders.cpp pulls them in.
+	struct EmbeddedShader
+	{
+		const char* fileName;
+		const uint32_t* code;
+		size_t wordCount;
+	};
+
+	class EmbeddedShaders
+	{
+	public:
+		//NOTE:fileName is the runtime path, e.g. "source/model.vert.spv". nullptr when it is not embedded.
+		static const EmbeddedShader* find(const std::string& fileName);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "file_watcher.hpp"
+
+namespace app
+{
+	void FileWatcher::watch(const std::filesystem::path& path)
+	{
+		m_files[path] = getWriteTime(path);
+	}
+
+	std::vector<std::filesystem::path> FileWatcher::poll()
+	{
+		std::vector<std::filesystem::path> changed;
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - m_lastPoll < m_interval)
+		{
+			return changed;
+		}
+		m_lastPoll = now;
+
+		for (auto& [path, writeTime] : m_files)
+		{
+			const auto currentWriteTime = getWriteTime(path);
+			if (currentWriteTime != writeTime)
+			{
+				writeTime = currentWriteTime;
+				changed.push_back(path);
+			}
+		}
+		return changed;
+	}
+
+	std::filesystem::file_time_type FileWatcher::getWriteTime(const std::filesystem::path& path)
+	{
+		std::error_code errorCode;
+		const auto writeTime = std::filesystem::last_write_time(path, errorCode);
+		return errorCode ? std::filesystem::file_time_type::min() : writeTime;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+namespace app
+{
+	//NOTE:Polls modification times. Cheap enough for a handful of shader files and needs no platform API.
+	//     Missing files are watched too and report a change once they appear.
+	class FileWatcher
+	{
+	public:
+		//NOTE:Takes the current modification time as the baseline, so watching again swallows a pending change.
+		void watch(const std::filesystem::path& path);
+		bool isWatching(const std::filesystem::path& path) const { return m_files.count(path) != 0; }
+
+		//NOTE:Files whose modification time changed since the last poll. Looks at the disk at most once per interval.
+		std::vector<std::filesystem::path> poll();
+
+		void setInterval(std::chrono::milliseconds interval) { m_interval = interval; }
+
+	private:
+		static std::filesystem::file_time_type getWriteTime(const std::filesystem::path& path);
+
+		std::map<std::filesystem::path, std::filesystem::file_time_type> m_files;
+		std::chrono::milliseconds m_interval{ 250 };
+		std::chrono::steady_clock::time_point m_lastPoll{};
+	};
+}
\ No newline at end of file
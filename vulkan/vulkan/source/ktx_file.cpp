@@ -0,0 +1,310 @@
+#include "ktx_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+namespace app
+{
+	namespace
+	{
+		constexpr uint8_t IDENTIFIER[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+		constexpr std::string_view SOURCE_HASH_KEY = "VkAppSourceHash";
+
+		//NOTE:Khronos Data Format values used by the descriptors below.
+		constexpr uint32_t KHR_DF_MODEL_RGBSDA = 1;
+		constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+		constexpr uint32_t KHR_DF_MODEL_BC3 = 130;
+		constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+		constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+		constexpr uint32_t KHR_DF_CHANNEL_COLOR = 0;
+		constexpr uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+
+		size_t alignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		bool isSupportedFormat(uint32_t vkFormat)
+		{
+			return
+				vkFormat == TextureCompressor::FORMAT_R8G8B8A8_UNORM ||
+				vkFormat == TextureCompressor::FORMAT_BC1_RGB_UNORM ||
+				vkFormat == TextureCompressor::FORMAT_BC3_UNORM;
+		}
+
+		uint32_t getLevelSize(uint32_t vkFormat, uint32_t width, uint32_t height)
+		{
+			if (vkFormat == TextureCompressor::FORMAT_R8G8B8A8_UNORM)
+			{
+				return width * height * 4;
+			}
+			return ((width + 3) / 4) * ((height + 3) / 4) * TextureCompressor::getBlockSize(vkFormat);
+		}
+
+		//NOTE:KTX2 aligns every level to lcm(texel block size, 4).
+		uint32_t getLevelAlignment(uint32_t vkFormat)
+		{
+			return vkFormat == TextureCompressor::FORMAT_R8G8B8A8_UNORM ? 4u : TextureCompressor::getBlockSize(vkFormat);
+		}
+	}
+
+	KtxFile::KtxFile(std::filesystem::path path) :
+		m_path(std::move(path))
+	{
+	}
+
+	bool KtxFile::load(uint64_t sourceHash, TextureData& texture) const
+	{
+		std::ifstream stream(m_path, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+
+		Header header{};
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (
+			!stream ||
+			std::memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 ||
+			!isSupportedFormat(header.vkFormat) ||
+			header.pixelWidth == 0 ||
+			header.pixelHeight == 0 ||
+			header.pixelDepth != 0 ||
+			header.layerCount != 0 ||
+			header.faceCount != 1 ||
+			header.levelCount == 0 ||
+			header.levelCount > MipmapBuilder::getLevelCount(header.pixelWidth, header.pixelHeight) ||
+			header.supercompressionScheme != 0
+			)
+		{
+			return false;
+		}
+
+		std::vector<LevelIndex> levelIndices(header.levelCount);
+		stream.read(reinterpret_cast<char*>(levelIndices.data()), sizeof(LevelIndex) * levelIndices.size());
+
+		std::vector<char> keyValueData(header.kvdByteLength);
+		stream.seekg(header.kvdByteOffset);
+		stream.read(keyValueData.data(), keyValueData.size());
+		if (!stream)
+		{
+			return false;
+		}
+
+		//NOTE:Entries are a uint32 length followed by "key\0value", each padded to 4 bytes.
+		auto sourceHashFound = false;
+		for (size_t offset = 0; offset + sizeof(uint32_t) <= keyValueData.size() && !sourceHashFound;)
+		{
+			uint32_t length = 0;
+			std::memcpy(&length, keyValueData.data() + offset, sizeof(length));
+			offset += sizeof(length);
+			if (offset + length > keyValueData.size())
+			{
+				return false;
+			}
+
+			const std::string_view entry(keyValueData.data() + offset, length);
+			if (entry.size() == SOURCE_HASH_KEY.size() + 1 + sizeof(uint64_t) && entry.substr(0, SOURCE_HASH_KEY.size() + 1) == std::string_view(SOURCE_HASH_KEY.data(), SOURCE_HASH_KEY.size() + 1))
+			{
+				uint64_t storedHash = 0;
+				std::memcpy(&storedHash, entry.data() + SOURCE_HASH_KEY.size() + 1, sizeof(storedHash));
+				if (storedHash != sourceHash)
+				{
+					return false;
+				}
+				sourceHashFound = true;
+			}
+			offset = alignUp(offset + length, 4);
+		}
+		if (!sourceHashFound)
+		{
+			return false;
+		}
+
+		TextureData result{};
+		result.vkFormat = header.vkFormat;
+
+		size_t size = 0;
+		for (uint32_t level = 0, width = header.pixelWidth, height = header.pixelHeight; level < header.levelCount; ++level)
+		{
+			if (levelIndices[level].byteLength != getLevelSize(header.vkFormat, width, height))
+			{
+				return false;
+			}
+			result.mips.levels.push_back(MipLevel{ width, height, size });
+			size += levelIndices[level].byteLength;
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+
+		result.mips.pixels.resize(size);
+		for (uint32_t level = 0; level < header.levelCount; ++level)
+		{
+			stream.seekg(levelIndices[level].byteOffset);
+			stream.read(reinterpret_cast<char*>(result.mips.pixels.data() + result.mips.levels[level].offset), levelIndices[level].byteLength);
+		}
+		if (!stream)
+		{
+			return false;
+		}
+
+		texture = std::move(result);
+		return true;
+	}
+
+	void KtxFile::save(uint64_t sourceHash, const TextureData& texture) const
+	{
+		if (texture.mips.levels.empty() || !isSupportedFormat(texture.vkFormat))
+		{
+			return;
+		}
+
+		const auto levelCount = static_cast<uint32_t>(texture.mips.levels.size());
+		const auto dataFormatDescriptor = makeDataFormatDescriptor(texture.vkFormat);
+
+		std::vector<char> keyValueData(sizeof(uint32_t) + SOURCE_HASH_KEY.size() + 1 + sizeof(uint64_t));
+		{
+			const auto length = static_cast<uint32_t>(keyValueData.size() - sizeof(uint32_t));
+			std::memcpy(keyValueData.data(), &length, sizeof(length));
+			std::memcpy(keyValueData.data() + sizeof(length), SOURCE_HASH_KEY.data(), SOURCE_HASH_KEY.size());
+			std::memcpy(keyValueData.data() + keyValueData.size() - sizeof(sourceHash), &sourceHash, sizeof(sourceHash));
+			keyValueData.resize(alignUp(keyValueData.size(), 4));
+		}
+
+		Header header{};
+		std::memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+		header.vkFormat = texture.vkFormat;
+		header.typeSize = 1;
+		header.pixelWidth = texture.mips.levels.front().width;
+		header.pixelHeight = texture.mips.levels.front().height;
+		header.faceCount = 1;
+		header.levelCount = levelCount;
+		header.dfdByteOffset = static_cast<uint32_t>(sizeof(Header) + sizeof(LevelIndex) * levelCount);
+		header.dfdByteLength = static_cast<uint32_t>(sizeof(uint32_t) * dataFormatDescriptor.size());
+		header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+		header.kvdByteLength = static_cast<uint32_t>(keyValueData.size());
+
+		//NOTE:Level data is laid out smallest mip first.
+		const auto alignment = getLevelAlignment(texture.vkFormat);
+		std::vector<LevelIndex> levelIndices(levelCount);
+		auto offset = static_cast<size_t>(header.kvdByteOffset) + header.kvdByteLength;
+		for (auto level = levelCount; level-- > 0;)
+		{
+			const auto& mipLevel = texture.mips.levels[level];
+			const auto end = level + 1 < levelCount ? texture.mips.levels[level + 1].offset : texture.mips.pixels.size();
+			const auto length = end - mipLevel.offset;
+			offset = alignUp(offset, alignment);
+			levelIndices[level] = LevelIndex{ offset, length, length };
+			offset += length;
+		}
+
+		//NOTE:Write to a temporary file first so a crash never leaves a truncated texture behind.
+		auto temporaryPath = m_path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return;
+			}
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(levelIndices.data()), sizeof(LevelIndex) * levelIndices.size());
+			stream.write(reinterpret_cast<const char*>(dataFormatDescriptor.data()), sizeof(uint32_t) * dataFormatDescriptor.size());
+			stream.write(keyValueData.data(), keyValueData.size());
+
+			auto position = static_cast<size_t>(header.kvdByteOffset) + header.kvdByteLength;
+			for (auto level = levelCount; level-- > 0;)
+			{
+				const auto& levelIndex = levelIndices[level];
+				const std::vector<char> padding(levelIndex.byteOffset - position, 0);
+				stream.write(padding.data(), padding.size());
+				stream.write(reinterpret_cast<const char*>(texture.mips.pixels.data() + texture.mips.levels[level].offset), levelIndex.byteLength);
+				position = levelIndex.byteOffset + levelIndex.byteLength;
+			}
+
+			if (!stream)
+			{
+				return;
+			}
+		}
+
+		std::error_code errorCode;
+		std::filesystem::rename(temporaryPath, m_path, errorCode);
+		if (errorCode)
+		{
+			std::filesystem::remove(temporaryPath, errorCode);
+		}
+	}
+
+	uint64_t KtxFile::computeSourceHash(const void* data, size_t size)
+	{
+		auto hash = 0xcbf29ce484222325ull;
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	std::vector<uint32_t> KtxFile::makeDataFormatDescriptor(uint32_t vkFormat)
+	{
+		struct Sample
+		{
+			uint32_t bitOffset;
+			uint32_t bitLength;
+			uint32_t channel;
+			uint32_t upper;
+		};
+
+		std::vector<Sample> samples;
+		uint32_t colorModel = KHR_DF_MODEL_RGBSDA;
+		uint32_t texelBlockDimension = 0;
+		uint32_t bytesPlane0 = 4;
+		switch (vkFormat)
+		{
+		case TextureCompressor::FORMAT_BC1_RGB_UNORM:
+			colorModel = KHR_DF_MODEL_BC1A;
+			texelBlockDimension = 3 | (3 << 8);
+			bytesPlane0 = 8;
+			samples.push_back(Sample{ 0, 64, KHR_DF_CHANNEL_COLOR, 0xffffffffu });
+			break;
+		case TextureCompressor::FORMAT_BC3_UNORM:
+			colorModel = KHR_DF_MODEL_BC3;
+			texelBlockDimension = 3 | (3 << 8);
+			bytesPlane0 = 16;
+			samples.push_back(Sample{ 0, 64, KHR_DF_CHANNEL_ALPHA, 0xffffffffu });
+			samples.push_back(Sample{ 64, 64, KHR_DF_CHANNEL_COLOR, 0xffffffffu });
+			break;
+		default:
+			for (uint32_t channel : { 0u, 1u, 2u, KHR_DF_CHANNEL_ALPHA })
+			{
+				samples.push_back(Sample{ static_cast<uint32_t>(samples.size()) * 8, 8, channel, 0xffu });
+			}
+			break;
+		}
+
+		//NOTE:Total size, then one basic descriptor block (6 words + 4 words per sample).
+		const auto blockSize = static_cast<uint32_t>(sizeof(uint32_t) * (6 + 4 * samples.size()));
+		std::vector<uint32_t> words;
+		words.push_back(static_cast<uint32_t>(sizeof(uint32_t)) + blockSize);
+		words.push_back(0);
+		words.push_back(2 | (blockSize << 16));
+		words.push_back(colorModel | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+		words.push_back(texelBlockDimension);
+		words.push_back(bytesPlane0);
+		words.push_back(0);
+		for (const auto& sample : samples)
+		{
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(sample.upper);
+		}
+		return words;
+	}
+}
\ No newline at end of file
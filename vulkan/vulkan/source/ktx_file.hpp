@@ -0,0 +1,58 @@
+#pragma once
+
+#include "texture_compressor.hpp"
+
+#include <filesystem>
+
+namespace app
+{
+	//NOTE:Minimal KTX2 reader / writer for the textures cooked by TextureCompressor.
+	//     One 2D image per file, no supercompression. The source hash lives in the key/value
+	//     data under "VkAppSourceHash" and invalidates the file when the image bytes change.
+	class KtxFile
+	{
+	public:
+		explicit KtxFile(std::filesystem::path path);
+
+		bool load(uint64_t sourceHash, TextureData& texture) const;
+		void save(uint64_t sourceHash, const TextureData& texture) const;
+
+		const std::filesystem::path& getPath() const { return m_path; }
+
+		//NOTE:FNV-1a over the encoded source image.
+		static uint64_t computeSourceHash(const void* data, size_t size);
+
+	private:
+		struct Header
+		{
+			uint8_t identifier[12];
+			uint32_t vkFormat;
+			uint32_t typeSize;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t layerCount;
+			uint32_t faceCount;
+			uint32_t levelCount;
+			uint32_t supercompressionScheme;
+			uint32_t dfdByteOffset;
+			uint32_t dfdByteLength;
+			uint32_t kvdByteOffset;
+			uint32_t kvdByteLength;
+			uint64_t sgdByteOffset;
+			uint64_t sgdByteLength;
+		};
+		static_assert(sizeof(Header) == 80, "KTX2 header and index must be packed");
+
+		struct LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+			uint64_t uncompressedByteLength;
+		};
+
+		static std::vector<uint32_t> makeDataFormatDescriptor(uint32_t vkFormat);
+
+		std::filesystem::path m_path;
+	};
+}
\ No newline at end of file
@@ -8,12 +8,24 @@ int main()
 {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, 0);
+	glfwWindowHint(GLFW_RESIZABLE, 1);
 	auto window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, APP_TITLE, nullptr, nullptr);
 
 	app::ModelApp vulkanAppBase;
 	vulkanAppBase.initialize(window, APP_TITLE);
 
+	//NOTE:Dropping a .vrm/.glb onto the window swaps the model without stalling the render loop.
+	glfwSetWindowUserPointer(window, &vulkanAppBase);
+	glfwSetDropCallback(window, [](GLFWwindow* window, int count, const char** paths)
+		{
+			if (count <= 0)
+			{
+				return;
+			}
+			auto* modelApp = static_cast<app::ModelApp*>(glfwGetWindowUserPointer(window));
+			modelApp->loadModel(std::filesystem::u8path(paths[0]));
+		});
+
 	while (glfwWindowShouldClose(window) == GLFW_FALSE)
 	{
 		glfwPollEvents();
@@ -0,0 +1,31 @@
+#version 450
+layout(location=0) in vec2 inUV;
+
+layout(location=0) out vec4 outColor;
+
+layout(binding=1) uniform sampler2DArray diffuseMap;
+
+layout(push_constant) uniform MaterialParameters
+{
+    layout(offset=32) uint layer;
+};
+
+// 0:opaque 1:mask 2:blend, see ModelApp::SPECIALIZATION_ALPHA_MODE.
+layout(constant_id=0) const uint ALPHA_MODE = 0;
+layout(constant_id=1) const float ALPHA_CUTOFF = 0.5;
+
+void main()
+{
+    vec4 color = texture(diffuseMap,vec3(inUV,layer));
+
+    if(ALPHA_MODE == 1 && color.a < ALPHA_CUTOFF)
+    {
+        discard;
+    }
+    if(ALPHA_MODE == 0)
+    {
+        color.a = 1.0;
+    }
+
+    outColor = color;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace app
+{
+	struct ModelVertex
+	{
+		glm::vec3 position;
+		glm::vec3 color;
+		glm::vec2 uv;
+	};
+
+	//NOTE:A cluster of triangles stored contiguously in the mesh index buffer.
+	//     The cone is in meshoptimizer's convention, coneCutoff >= 1 disables backface rejection.
+	struct Meshlet
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t vertexCount;
+		float radius;
+		glm::vec3 center;
+		float coneCutoff;
+		glm::vec3 coneAxis;
+		float padding;
+	};
+
+	//NOTE:A range of the mesh index buffer. error is the simplification error in model units.
+	struct MeshLod
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
+	struct VertexCacheStatistics
+	{
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+
+	//NOTE:CPU side geometry of a single glTF primitive before it is uploaded.
+	//     Everything in here is what gets written to the cooked cache.
+	struct MeshData
+	{
+		std::vector<ModelVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshLod> lods;
+		int materialIndex = 0;
+		//NOTE:Vertex count as imported, before welding.
+		uint32_t sourceVertexCount = 0;
+
+		glm::vec3 boundsCenter{};
+		float boundsRadius = 0.0f;
+
+		VertexCacheStatistics sourceStatistics{};
+		VertexCacheStatistics optimizedStatistics{};
+	};
+}
\ No newline at end of file
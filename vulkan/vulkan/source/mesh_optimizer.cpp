@@ -0,0 +1,504 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace app
+{
+	namespace
+	{
+		constexpr float CACHE_DECAY_POWER = 1.5f;
+		constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+		constexpr float VALENCE_BOOST_SCALE = 2.0f;
+		constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+		constexpr uint32_t INVALID_INDEX = ~0u;
+
+		float computeVertexScore(int cachePosition, uint32_t remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+
+			auto score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				if (cachePosition < 3)
+				{
+					score = LAST_TRIANGLE_SCORE;
+				}
+				else
+				{
+					const auto scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+					score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+				}
+			}
+
+			score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+			return score;
+		}
+
+		//NOTE:FIFO cache simulated with timestamps, a vertex is resident while
+		//     fewer than cacheSize misses happened since it was loaded.
+		class FifoCache
+		{
+		public:
+			FifoCache(size_t vertexCount, uint32_t cacheSize) :
+				m_timestamps(vertexCount, 0u),
+				m_cacheSize(cacheSize),
+				m_timestamp(cacheSize + 1)
+			{}
+
+			bool access(uint32_t vertex)
+			{
+				if (m_timestamp - m_timestamps[vertex] > m_cacheSize)
+				{
+					m_timestamps[vertex] = m_timestamp++;
+					return false;
+				}
+				return true;
+			}
+
+			void reset()
+			{
+				m_timestamp += m_cacheSize + 1;
+			}
+
+		private:
+			std::vector<uint32_t> m_timestamps;
+			uint32_t m_cacheSize;
+			uint32_t m_timestamp;
+		};
+
+		uint32_t countMisses(FifoCache& cache, const uint32_t* triangle)
+		{
+			uint32_t misses = 0;
+			for (auto i = 0u; i < 3; ++i)
+			{
+				misses += cache.access(triangle[i]) ? 0 : 1;
+			}
+			return misses;
+		}
+
+		constexpr size_t VERTEX_KEY_SIZE = sizeof(ModelVertex) / sizeof(float);
+
+		struct VertexKey
+		{
+			uint32_t values[VERTEX_KEY_SIZE];
+
+			bool operator==(const VertexKey& other) const
+			{
+				return std::memcmp(values, other.values, sizeof(values)) == 0;
+			}
+		};
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey& key) const
+			{
+				//NOTE:FNV-1a over the key words.
+				uint64_t hash = 14695981039346656037ull;
+				for (auto value : key.values)
+				{
+					hash = (hash ^ value) * 1099511628211ull;
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		VertexKey makeVertexKey(const ModelVertex& vertex, float epsilon)
+		{
+			static_assert(sizeof(ModelVertex) == VERTEX_KEY_SIZE * sizeof(float), "ModelVertex must only hold floats");
+
+			float values[VERTEX_KEY_SIZE];
+			std::memcpy(values, &vertex, sizeof(values));
+
+			VertexKey key{};
+			for (auto i = 0u; i < VERTEX_KEY_SIZE; ++i)
+			{
+				if (epsilon > 0.0f)
+				{
+					const auto cell = static_cast<int32_t>(std::floor(values[i] / epsilon + 0.5f));
+					std::memcpy(&key.values[i], &cell, sizeof(cell));
+				}
+				else
+				{
+					//NOTE:+0 and -0 are the same vertex.
+					const auto value = values[i] == 0.0f ? 0.0f : values[i];
+					std::memcpy(&key.values[i], &value, sizeof(value));
+				}
+			}
+			return key;
+		}
+	}
+
+	void MeshOptimizer::weldVertices(std::vector<ModelVertex>& vertices, std::vector<uint32_t>& indices, float epsilon)
+	{
+		std::unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices;
+		uniqueVertices.reserve(vertices.size());
+
+		std::vector<uint32_t> remap(vertices.size());
+		std::vector<ModelVertex> result;
+		result.reserve(vertices.size());
+
+		for (auto i = 0u; i < vertices.size(); ++i)
+		{
+			const auto inserted = uniqueVertices.emplace(makeVertexKey(vertices[i], epsilon), static_cast<uint32_t>(result.size()));
+			if (inserted.second)
+			{
+				result.push_back(vertices[i]);
+			}
+			remap[i] = inserted.first->second;
+		}
+
+		auto writeCursor = 0u;
+		for (auto i = 0u; i + 2 < indices.size(); i += 3)
+		{
+			const auto a = remap[indices[i]];
+			const auto b = remap[indices[i + 1]];
+			const auto c = remap[indices[i + 2]];
+			if (a == b || b == c || c == a)
+			{
+				continue;
+			}
+			indices[writeCursor++] = a;
+			indices[writeCursor++] = b;
+			indices[writeCursor++] = c;
+		}
+		indices.resize(writeCursor);
+
+		vertices.swap(result);
+	}
+
+	void MeshOptimizer::optimize(MeshData& mesh)
+	{
+		mesh.sourceStatistics = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+		optimizeVertexCache(mesh.indices, mesh.vertices.size());
+		optimizeOverdraw(mesh.indices, mesh.vertices);
+		optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+		mesh.optimizedStatistics = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	}
+
+	void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		const auto triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<uint32_t> remainingTriangles(vertexCount, 0u);
+		for (auto index : indices)
+		{
+			++remainingTriangles[index];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0u);
+		std::partial_sum(remainingTriangles.begin(), remainingTriangles.end(), adjacencyOffsets.begin() + 1);
+
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			auto cursor = adjacencyOffsets;
+			for (auto i = 0u; i < indices.size(); ++i)
+			{
+				adjacency[cursor[indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (auto i = 0u; i < vertexCount; ++i)
+		{
+			vertexScores[i] = computeVertexScore(-1, remainingTriangles[i]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+
+		auto bestTriangle = INVALID_INDEX;
+		auto bestScore = -1.0f;
+		for (auto t = 0u; t < triangleCount; ++t)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+			if (triangleScores[t] > bestScore)
+			{
+				bestScore = triangleScores[t];
+				bestTriangle = t;
+			}
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		std::vector<uint32_t> cache, nextCache;
+		cache.reserve(CACHE_SIZE + 3);
+		nextCache.reserve(CACHE_SIZE + 3);
+
+		auto inputCursor = 0u;
+		for (auto emittedCount = 0u; emittedCount < triangleCount; ++emittedCount)
+		{
+			if (bestTriangle == INVALID_INDEX)
+			{
+				//NOTE:Nothing adjacent to the cache is left, continue in input order.
+				while (emitted[inputCursor])
+				{
+					++inputCursor;
+				}
+				bestTriangle = inputCursor;
+			}
+
+			const uint32_t triangle[3] =
+			{
+				indices[bestTriangle * 3],
+				indices[bestTriangle * 3 + 1],
+				indices[bestTriangle * 3 + 2]
+			};
+
+			result.insert(result.end(), triangle, triangle + 3);
+			emitted[bestTriangle] = true;
+
+			nextCache.assign(triangle, triangle + 3);
+			for (auto vertex : cache)
+			{
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				{
+					nextCache.push_back(vertex);
+				}
+			}
+
+			for (auto vertex : triangle)
+			{
+				auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+				auto end = begin + remainingTriangles[vertex];
+				auto it = std::find(begin, end, bestTriangle);
+				if (it != end)
+				{
+					std::iter_swap(it, end - 1);
+					--remainingTriangles[vertex];
+				}
+			}
+
+			for (auto i = 0u; i < nextCache.size(); ++i)
+			{
+				const auto vertex = nextCache[i];
+				cachePositions[vertex] = i < CACHE_SIZE ? static_cast<int>(i) : -1;
+				vertexScores[vertex] = computeVertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+			}
+
+			bestTriangle = INVALID_INDEX;
+			bestScore = -1.0f;
+			for (auto vertex : nextCache)
+			{
+				const auto begin = adjacencyOffsets[vertex];
+				const auto end = begin + remainingTriangles[vertex];
+				for (auto a = begin; a < end; ++a)
+				{
+					const auto t = adjacency[a];
+					triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+					if (triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = t;
+					}
+				}
+			}
+
+			if (nextCache.size() > CACHE_SIZE)
+			{
+				nextCache.resize(CACHE_SIZE);
+			}
+			cache.swap(nextCache);
+		}
+
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, float threshold)
+	{
+		const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		//NOTE:Hard boundaries are where the cache is fully missed, the order can change there for free.
+		std::vector<uint32_t> hardBoundaries;
+		{
+			FifoCache cache(vertices.size(), STATISTICS_CACHE_SIZE);
+			for (auto t = 0u; t < triangleCount; ++t)
+			{
+				if (countMisses(cache, &indices[t * 3]) == 3)
+				{
+					hardBoundaries.push_back(t);
+				}
+			}
+			if (hardBoundaries.empty() || hardBoundaries.front() != 0)
+			{
+				hardBoundaries.insert(hardBoundaries.begin(), 0);
+			}
+			hardBoundaries.push_back(triangleCount);
+		}
+
+		//NOTE:Soft boundaries split a hard cluster where doing so keeps ACMR within threshold.
+		std::vector<uint32_t> clusters;
+		{
+			FifoCache cache(vertices.size(), STATISTICS_CACHE_SIZE);
+			for (auto c = 0u; c + 1 < hardBoundaries.size(); ++c)
+			{
+				const auto begin = hardBoundaries[c];
+				const auto end = hardBoundaries[c + 1];
+
+				cache.reset();
+				auto clusterMisses = 0u;
+				for (auto t = begin; t < end; ++t)
+				{
+					clusterMisses += countMisses(cache, &indices[t * 3]);
+				}
+				const auto clusterThreshold = threshold * clusterMisses / (end - begin);
+
+				clusters.push_back(begin);
+
+				cache.reset();
+				auto runningMisses = 0u;
+				auto runningSize = 0u;
+				for (auto t = begin; t < end; ++t)
+				{
+					runningMisses += countMisses(cache, &indices[t * 3]);
+					++runningSize;
+
+					if (t + 1 < end && static_cast<float>(runningMisses) / runningSize <= clusterThreshold)
+					{
+						clusters.push_back(t + 1);
+						runningMisses = 0;
+						runningSize = 0;
+					}
+				}
+			}
+			clusters.push_back(triangleCount);
+		}
+
+		auto meshCentroid = glm::vec3(0.0f);
+		auto meshArea = 0.0f;
+
+		struct Cluster
+		{
+			uint32_t begin;
+			uint32_t end;
+			glm::vec3 centroid;
+			glm::vec3 normal;
+			float sortKey;
+		};
+		std::vector<Cluster> sortedClusters;
+		sortedClusters.reserve(clusters.size() - 1);
+
+		for (auto c = 0u; c + 1 < clusters.size(); ++c)
+		{
+			Cluster cluster{ clusters[c], clusters[c + 1], glm::vec3(0.0f), glm::vec3(0.0f), 0.0f };
+			auto clusterArea = 0.0f;
+			for (auto t = cluster.begin; t < cluster.end; ++t)
+			{
+				const auto& p0 = vertices[indices[t * 3]].position;
+				const auto& p1 = vertices[indices[t * 3 + 1]].position;
+				const auto& p2 = vertices[indices[t * 3 + 2]].position;
+
+				const auto normal = glm::cross(p1 - p0, p2 - p0);
+				const auto area = glm::length(normal);
+				const auto centroid = (p0 + p1 + p2) / 3.0f;
+
+				cluster.centroid += centroid * area;
+				cluster.normal += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += cluster.centroid;
+			meshArea += clusterArea;
+
+			if (clusterArea > 0.0f)
+			{
+				cluster.centroid /= clusterArea;
+			}
+			const auto normalLength = glm::length(cluster.normal);
+			if (normalLength > 0.0f)
+			{
+				cluster.normal /= normalLength;
+			}
+			sortedClusters.push_back(cluster);
+		}
+
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		for (auto& cluster : sortedClusters)
+		{
+			cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+		}
+
+		std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b)
+			{
+				return a.sortKey > b.sortKey;
+			});
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (const auto& cluster : sortedClusters)
+		{
+			result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+		}
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::optimizeVertexFetch(std::vector<ModelVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+		std::vector<ModelVertex> result;
+		result.reserve(vertices.size());
+
+		for (auto& index : indices)
+		{
+			if (remap[index] == INVALID_INDEX)
+			{
+				remap[index] = static_cast<uint32_t>(result.size());
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		vertices.swap(result);
+	}
+
+	VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStatistics statistics{};
+		const auto triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return statistics;
+		}
+
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<bool> referenced(vertexCount, false);
+		auto misses = 0u;
+		auto uniqueVertices = 0u;
+		for (auto index : indices)
+		{
+			misses += cache.access(index) ? 0 : 1;
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++uniqueVertices;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(misses) / triangleCount;
+		statistics.atvr = static_cast<float>(misses) / uniqueVertices;
+		return statistics;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+namespace app
+{
+	class MeshOptimizer
+	{
+	public:
+		static constexpr uint32_t CACHE_SIZE = 32;
+		static constexpr uint32_t STATISTICS_CACHE_SIZE = 16;
+		static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+		//NOTE:Runs the whole chain (vertex cache -> overdraw -> vertex fetch) in place.
+		static void optimize(MeshData& mesh);
+
+		//NOTE:Collapses vertices whose attributes all match and remaps the indices.
+		//     epsilon 0 compares bit patterns, otherwise attributes are snapped to an epsilon grid.
+		//     Triangles that become degenerate are dropped.
+		static void weldVertices(std::vector<ModelVertex>& vertices, std::vector<uint32_t>& indices, float epsilon = 0.0f);
+
+		//NOTE:Forsyth's linear-speed vertex cache optimisation.
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		//NOTE:Splits the cache optimized index stream into clusters and sorts them
+		//     front-to-back from the outside so early depth rejects more fragments.
+		//     threshold limits how much ACMR a cluster split is allowed to cost.
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, float threshold = OVERDRAW_THRESHOLD);
+
+		//NOTE:Reorders vertices in order of first use and drops unreferenced ones.
+		static void optimizeVertexFetch(std::vector<ModelVertex>& vertices, std::vector<uint32_t>& indices);
+
+		//NOTE:Simulates a FIFO post-transform cache.
+		//     ACMR = transformed vertices per triangle, ATVR = transformed vertices per referenced vertex.
+		static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = STATISTICS_CACHE_SIZE);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include "mesh_simplifier.hpp"
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace app
+{
+	namespace
+	{
+		struct Quadric
+		{
+			double a2, ab, ac, ad;
+			double b2, bc, bd;
+			double c2, cd;
+			double d2;
+			//NOTE:Summed area of the planes, the quadric is divided by it to get a squared distance.
+			double weight;
+		};
+
+		void addQuadric(Quadric& quadric, const Quadric& other)
+		{
+			quadric.a2 += other.a2; quadric.ab += other.ab; quadric.ac += other.ac; quadric.ad += other.ad;
+			quadric.b2 += other.b2; quadric.bc += other.bc; quadric.bd += other.bd;
+			quadric.c2 += other.c2; quadric.cd += other.cd;
+			quadric.d2 += other.d2;
+			quadric.weight += other.weight;
+		}
+
+		Quadric makePlaneQuadric(const glm::vec3& normal, double distance, double weight)
+		{
+			const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+			return Quadric
+			{
+				a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+				b * b * weight, b * c * weight, b * d * weight,
+				c * c * weight, c * d * weight,
+				d * d * weight,
+				weight
+			};
+		}
+
+		//NOTE:Area weighted mean of the squared distances from p to the planes.
+		double evaluateQuadric(const Quadric& q, const glm::vec3& p)
+		{
+			if (q.weight <= 0.0)
+			{
+				return 0.0;
+			}
+
+			const double x = p.x, y = p.y, z = p.z;
+			const auto result =
+				q.a2 * x * x + 2.0 * q.ab * x * y + 2.0 * q.ac * x * z + 2.0 * q.ad * x +
+				q.b2 * y * y + 2.0 * q.bc * y * z + 2.0 * q.bd * y +
+				q.c2 * z * z + 2.0 * q.cd * z +
+				q.d2;
+			return std::fabs(result) / q.weight;
+		}
+
+		struct PositionKey
+		{
+			uint32_t bits[3];
+
+			bool operator==(const PositionKey& other) const
+			{
+				return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+			}
+		};
+
+		struct PositionKeyHash
+		{
+			size_t operator()(const PositionKey& key) const
+			{
+				auto hash = static_cast<size_t>(key.bits[0]) * 73856093u;
+				hash ^= static_cast<size_t>(key.bits[1]) * 19349663u;
+				hash ^= static_cast<size_t>(key.bits[2]) * 83492791u;
+				return hash;
+			}
+		};
+
+		uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+		{
+			if (a > b)
+			{
+				std::swap(a, b);
+			}
+			return (static_cast<uint64_t>(a) << 32) | b;
+		}
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double cost;
+		};
+	}
+
+	std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<ModelVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		std::vector<uint32_t> result(indices);
+		auto maximumCost = 0.0;
+
+		if (resultError)
+		{
+			*resultError = 0.0f;
+		}
+
+		if (vertices.empty() || result.size() <= targetIndexCount)
+		{
+			return result;
+		}
+
+		const auto vertexCount = vertices.size();
+
+		//NOTE:Wedges sharing a position collapse to one canonical vertex for topology.
+		std::vector<uint32_t> canonical(vertexCount);
+		std::vector<uint32_t> wedgeCount(vertexCount, 0u);
+		{
+			std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positions;
+			positions.reserve(vertexCount);
+			for (auto i = 0u; i < vertexCount; ++i)
+			{
+				PositionKey key{};
+				std::memcpy(key.bits, &vertices[i].position, sizeof(key.bits));
+				auto it = positions.emplace(key, i).first;
+				canonical[i] = it->second;
+				++wedgeCount[it->second];
+			}
+		}
+
+		//NOTE:Work in a unit box so errors are relative to the extent.
+		auto minimum = vertices.front().position;
+		auto maximum = minimum;
+		for (const auto& vertex : vertices)
+		{
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+		const auto extent = maximum - minimum;
+		const auto scale = std::max(extent.x, std::max(extent.y, extent.z));
+		const auto inverseScale = scale > 0.0f ? 1.0f / scale : 1.0f;
+
+		std::vector<glm::vec3> positions(vertexCount);
+		for (auto i = 0u; i < vertexCount; ++i)
+		{
+			positions[i] = (vertices[i].position - minimum) * inverseScale;
+		}
+
+		std::vector<bool> locked(vertexCount, false);
+		for (auto i = 0u; i < vertexCount; ++i)
+		{
+			locked[canonical[i]] = locked[canonical[i]] || wedgeCount[canonical[i]] > 1;
+		}
+
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeUseCounts;
+			edgeUseCounts.reserve(result.size());
+			for (auto i = 0u; i + 2 < result.size(); i += 3)
+			{
+				for (auto k = 0u; k < 3; ++k)
+				{
+					++edgeUseCounts[makeEdgeKey(canonical[result[i + k]], canonical[result[i + (k + 1) % 3]])];
+				}
+			}
+			for (const auto& edge : edgeUseCounts)
+			{
+				if (edge.second != 2)
+				{
+					locked[static_cast<uint32_t>(edge.first >> 32)] = true;
+					locked[static_cast<uint32_t>(edge.first & 0xffffffffu)] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount, Quadric{});
+		for (auto i = 0u; i + 2 < result.size(); i += 3)
+		{
+			const auto& p0 = positions[canonical[result[i]]];
+			const auto& p1 = positions[canonical[result[i + 1]]];
+			const auto& p2 = positions[canonical[result[i + 2]]];
+
+			auto normal = glm::cross(p1 - p0, p2 - p0);
+			const auto area = glm::length(normal);
+			if (area <= 0.0f)
+			{
+				continue;
+			}
+			normal /= area;
+
+			const auto quadric = makePlaneQuadric(normal, -glm::dot(normal, p0), area);
+			for (auto k = 0u; k < 3; ++k)
+			{
+				addQuadric(quadrics[canonical[result[i + k]]], quadric);
+			}
+		}
+
+		const auto maximumAllowedCost = static_cast<double>(targetError) * targetError;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> collapseRemap(vertexCount);
+		std::vector<bool> touched(vertexCount);
+
+		while (result.size() > targetIndexCount)
+		{
+			const auto triangleCount = static_cast<uint32_t>(result.size() / 3);
+
+			//NOTE:canonical vertex -> triangles
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+			for (auto index : result)
+			{
+				++adjacencyOffsets[canonical[index] + 1];
+			}
+			for (auto i = 0u; i < vertexCount; ++i)
+			{
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			}
+			adjacency.resize(result.size());
+			{
+				auto cursor = adjacencyOffsets;
+				for (auto i = 0u; i < result.size(); ++i)
+				{
+					adjacency[cursor[canonical[result[i]]]++] = i / 3;
+				}
+			}
+
+			collapses.clear();
+			for (auto i = 0u; i < result.size(); i += 3)
+			{
+				for (auto k = 0u; k < 3; ++k)
+				{
+					const auto from = result[i + k];
+					const auto to = result[i + (k + 1) % 3];
+					const auto canonicalFrom = canonical[from];
+					const auto canonicalTo = canonical[to];
+					if (locked[canonicalFrom] || canonicalFrom == canonicalTo)
+					{
+						continue;
+					}
+
+					auto quadric = quadrics[canonicalFrom];
+					addQuadric(quadric, quadrics[canonicalTo]);
+					const auto cost = evaluateQuadric(quadric, positions[canonicalTo]);
+					if (cost <= maximumAllowedCost)
+					{
+						collapses.push_back(Collapse{ from, to, cost });
+					}
+				}
+			}
+
+			if (collapses.empty())
+			{
+				break;
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+				{
+					return a.cost < b.cost;
+				});
+
+			for (auto i = 0u; i < vertexCount; ++i)
+			{
+				collapseRemap[i] = i;
+			}
+			std::fill(touched.begin(), touched.end(), false);
+
+			const auto trianglesToRemove = (result.size() - targetIndexCount) / 3;
+			auto removedTriangles = 0u;
+			auto collapseCount = 0u;
+
+			for (const auto& collapse : collapses)
+			{
+				const auto canonicalFrom = canonical[collapse.from];
+				const auto canonicalTo = canonical[collapse.to];
+				if (touched[canonicalFrom] || touched[canonicalTo])
+				{
+					continue;
+				}
+
+				//NOTE:Reject collapses that flip a neighbouring triangle.
+				auto flips = false;
+				auto removes = 0u;
+				const auto& target = positions[canonicalTo];
+				for (auto a = adjacencyOffsets[canonicalFrom]; a < adjacencyOffsets[canonicalFrom + 1] && !flips; ++a)
+				{
+					const auto* triangle = &result[adjacency[a] * 3];
+					uint32_t corners[3] = { canonical[triangle[0]], canonical[triangle[1]], canonical[triangle[2]] };
+					if (corners[0] == canonicalTo || corners[1] == canonicalTo || corners[2] == canonicalTo)
+					{
+						++removes;
+						continue;
+					}
+
+					const auto before = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+					for (auto& corner : corners)
+					{
+						corner = corner == canonicalFrom ? ~0u : corner;
+					}
+					const auto& q0 = corners[0] == ~0u ? target : positions[corners[0]];
+					const auto& q1 = corners[1] == ~0u ? target : positions[corners[1]];
+					const auto& q2 = corners[2] == ~0u ? target : positions[corners[2]];
+					const auto after = glm::cross(q1 - q0, q2 - q0);
+
+					flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+				}
+
+				if (flips)
+				{
+					continue;
+				}
+
+				collapseRemap[collapse.from] = collapse.to;
+				addQuadric(quadrics[canonicalTo], quadrics[canonicalFrom]);
+				maximumCost = std::max(maximumCost, collapse.cost);
+
+				//NOTE:Freeze the whole one-ring so flip checks stay valid within this pass.
+				for (auto a = adjacencyOffsets[canonicalFrom]; a < adjacencyOffsets[canonicalFrom + 1]; ++a)
+				{
+					const auto* triangle = &result[adjacency[a] * 3];
+					for (auto k = 0u; k < 3; ++k)
+					{
+						touched[canonical[triangle[k]]] = true;
+					}
+				}
+
+				++collapseCount;
+				removedTriangles += removes;
+				if (removedTriangles >= trianglesToRemove)
+				{
+					break;
+				}
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			auto writeCursor = 0u;
+			for (auto t = 0u; t < triangleCount; ++t)
+			{
+				const auto i0 = collapseRemap[result[t * 3]];
+				const auto i1 = collapseRemap[result[t * 3 + 1]];
+				const auto i2 = collapseRemap[result[t * 3 + 2]];
+				const auto c0 = canonical[i0];
+				const auto c1 = canonical[i1];
+				const auto c2 = canonical[i2];
+				if (c0 == c1 || c1 == c2 || c2 == c0)
+				{
+					continue;
+				}
+				result[writeCursor++] = i0;
+				result[writeCursor++] = i1;
+				result[writeCursor++] = i2;
+			}
+			result.resize(writeCursor);
+		}
+
+		if (resultError)
+		{
+			*resultError = static_cast<float>(std::sqrt(maximumCost));
+		}
+		return result;
+	}
+
+	void MeshSimplifier::generateLods(MeshData& mesh, uint32_t lodCount)
+	{
+		computeBounds(mesh);
+
+		const auto baseIndexCount = static_cast<uint32_t>(mesh.indices.size());
+		mesh.lods.clear();
+		mesh.lods.push_back(MeshLod{ 0, baseIndexCount, 0.0f });
+
+		if (mesh.vertices.empty())
+		{
+			return;
+		}
+
+		auto minimum = mesh.vertices.front().position;
+		auto maximum = minimum;
+		for (const auto& vertex : mesh.vertices)
+		{
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+		const auto extent = maximum - minimum;
+		const auto scale = std::max(extent.x, std::max(extent.y, extent.z));
+
+		std::vector<uint32_t> current(mesh.indices.begin(), mesh.indices.begin() + baseIndexCount);
+		auto accumulatedError = 0.0f;
+
+		for (auto level = 1u; level < lodCount; ++level)
+		{
+			const auto targetIndexCount = static_cast<size_t>(baseIndexCount >> level) / 3 * 3;
+
+			auto levelError = 0.0f;
+			auto lodIndices = simplify(mesh.vertices, current, targetIndexCount, LOD_TARGET_ERROR, &levelError);
+
+			//NOTE:Stop when the error budget no longer buys a meaningful reduction.
+			if (lodIndices.empty() || lodIndices.size() * 10 >= current.size() * 9)
+			{
+				break;
+			}
+
+			MeshOptimizer::optimizeVertexCache(lodIndices, mesh.vertices.size());
+
+			//NOTE:Each level starts from the previous one so errors add up.
+			accumulatedError += levelError;
+
+			mesh.lods.push_back(MeshLod{ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(lodIndices.size()), accumulatedError * scale });
+			mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+			current.swap(lodIndices);
+		}
+	}
+
+	void MeshSimplifier::computeBounds(MeshData& mesh)
+	{
+		mesh.boundsCenter = glm::vec3(0.0f);
+		mesh.boundsRadius = 0.0f;
+		if (mesh.vertices.empty())
+		{
+			return;
+		}
+
+		auto minimum = mesh.vertices.front().position;
+		auto maximum = minimum;
+		for (const auto& vertex : mesh.vertices)
+		{
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+
+		mesh.boundsCenter = (minimum + maximum) * 0.5f;
+		for (const auto& vertex : mesh.vertices)
+		{
+			mesh.boundsRadius = std::max(mesh.boundsRadius, glm::distance(mesh.boundsCenter, vertex.position));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+namespace app
+{
+	class MeshSimplifier
+	{
+	public:
+		//NOTE:Including the full resolution level.
+		static constexpr uint32_t LOD_COUNT = 4;
+		//NOTE:Relative to the mesh extent.
+		static constexpr float LOD_TARGET_ERROR = 0.05f;
+
+		//NOTE:Quadric error metric edge collapse that only rewrites indices, so every
+		//     level shares the original vertex buffer. Attribute seams and open borders
+		//     are locked to keep uv and silhouettes intact.
+		//     resultError is relative to the mesh extent.
+		static std::vector<uint32_t> simplify(const std::vector<ModelVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+		//NOTE:Appends the coarser levels to mesh.indices and fills mesh.lods and the bounds.
+		static void generateLods(MeshData& mesh, uint32_t lodCount = LOD_COUNT);
+
+		static void computeBounds(MeshData& mesh);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace app
+{
+	Frustum Frustum::fromMatrix(const glm::mat4& matrix)
+	{
+		auto row = [&matrix](int i)
+		{
+			return glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+		};
+
+		const auto x = row(0);
+		const auto y = row(1);
+		const auto z = row(2);
+		const auto w = row(3);
+
+		Frustum frustum{};
+		frustum.planes[0] = w + x;
+		frustum.planes[1] = w + x * -1.0f;
+		frustum.planes[2] = w + y;
+		frustum.planes[3] = w + y * -1.0f;
+		frustum.planes[4] = w + z;
+		frustum.planes[5] = w + z * -1.0f;
+
+		for (auto& plane : frustum.planes)
+		{
+			const auto length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+			if (length > 0.0f)
+			{
+				plane = plane * (1.0f / length);
+			}
+		}
+		return frustum;
+	}
+
+	std::vector<Meshlet> MeshletBuilder::build(const MeshData& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+	{
+		std::vector<Meshlet> meshlets;
+
+		//NOTE:Holds the id of the meshlet a vertex was last added to.
+		std::vector<uint32_t> vertexOwner(mesh.vertices.size(), ~0u);
+
+		Meshlet current{};
+		auto flush = [&]()
+		{
+			if (current.indexCount == 0)
+			{
+				return;
+			}
+			computeBounds(mesh, current);
+			meshlets.push_back(current);
+			current = Meshlet{};
+			current.firstIndex = meshlets.back().firstIndex + meshlets.back().indexCount;
+		};
+
+		for (auto i = 0u; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const auto meshletId = static_cast<uint32_t>(meshlets.size());
+
+			auto newVertices = 0u;
+			for (auto k = 0u; k < 3; ++k)
+			{
+				newVertices += vertexOwner[mesh.indices[i + k]] != meshletId ? 1 : 0;
+			}
+
+			if (current.vertexCount + newVertices > maxVertices || current.indexCount / 3 + 1 > maxTriangles)
+			{
+				flush();
+			}
+
+			const auto id = static_cast<uint32_t>(meshlets.size());
+			for (auto k = 0u; k < 3; ++k)
+			{
+				auto& owner = vertexOwner[mesh.indices[i + k]];
+				if (owner != id)
+				{
+					owner = id;
+					++current.vertexCount;
+				}
+			}
+			current.indexCount += 3;
+		}
+		flush();
+
+		return meshlets;
+	}
+
+	void MeshletBuilder::computeBounds(const MeshData& mesh, Meshlet& meshlet)
+	{
+		const auto begin = mesh.indices.begin() + meshlet.firstIndex;
+		const auto end = begin + meshlet.indexCount;
+
+		auto minimum = mesh.vertices[*begin].position;
+		auto maximum = minimum;
+		for (auto it = begin; it != end; ++it)
+		{
+			minimum = glm::min(minimum, mesh.vertices[*it].position);
+			maximum = glm::max(maximum, mesh.vertices[*it].position);
+		}
+
+		meshlet.center = (minimum + maximum) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (auto it = begin; it != end; ++it)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, mesh.vertices[*it].position));
+		}
+
+		auto axis = glm::vec3(0.0f);
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+		for (auto it = begin; it != end; it += 3)
+		{
+			const auto& p0 = mesh.vertices[it[0]].position;
+			const auto& p1 = mesh.vertices[it[1]].position;
+			const auto& p2 = mesh.vertices[it[2]].position;
+
+			const auto normal = glm::cross(p1 - p0, p2 - p0);
+			const auto area = glm::length(normal);
+			if (area <= 0.0f)
+			{
+				continue;
+			}
+			normals.push_back(normal / area);
+			axis += normals.back();
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		const auto axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 0.0f)
+		{
+			return;
+		}
+		axis /= axisLength;
+
+		auto minimumDot = 1.0f;
+		for (const auto& normal : normals)
+		{
+			minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+		}
+
+		//NOTE:Wider than ~85 degrees is almost never rejected, skip the test for those.
+		if (minimumDot <= 0.1f)
+		{
+			return;
+		}
+
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+
+	bool MeshletCuller::isVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition, bool cullBackface)
+	{
+		for (const auto& plane : frustum.planes)
+		{
+			if (glm::dot(glm::vec3(plane.x, plane.y, plane.z), meshlet.center) + plane.w < -meshlet.radius)
+			{
+				return false;
+			}
+		}
+
+		if (cullBackface && meshlet.coneCutoff < 1.0f)
+		{
+			const auto toCenter = meshlet.center - cameraPosition;
+			if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
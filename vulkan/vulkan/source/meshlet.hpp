@@ -0,0 +1,34 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+namespace app
+{
+	struct Frustum
+	{
+		//NOTE:xyz = inward facing normal, w = distance.
+		glm::vec4 planes[6];
+
+		static Frustum fromMatrix(const glm::mat4& matrix);
+	};
+
+	class MeshletBuilder
+	{
+	public:
+		static constexpr uint32_t MAX_VERTICES = 64;
+		static constexpr uint32_t MAX_TRIANGLES = 124;
+
+		//NOTE:Triangles are grouped greedily in index order, so the index buffer keeps
+		//     the vertex cache / overdraw order and each meshlet is a contiguous range.
+		static std::vector<Meshlet> build(const MeshData& mesh, uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+		static void computeBounds(const MeshData& mesh, Meshlet& meshlet);
+	};
+
+	class MeshletCuller
+	{
+	public:
+		//NOTE:frustum and cameraPosition are expected in the mesh's local space.
+		static bool isVisible(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition, bool cullBackface);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "mipmap_builder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace app
+{
+	uint32_t MipmapBuilder::getLevelCount(uint32_t width, uint32_t height)
+	{
+		auto size = std::max(width, height);
+		uint32_t levelCount = 1;
+		while (size > 1)
+		{
+			size >>= 1;
+			++levelCount;
+		}
+		return levelCount;
+	}
+
+	MipChain MipmapBuilder::build(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t channelCount)
+	{
+		MipChain chain{};
+
+		const auto levelCount = getLevelCount(width, height);
+		chain.levels.reserve(levelCount);
+
+		size_t size = 0;
+		for (uint32_t level = 0, w = width, h = height; level < levelCount; ++level)
+		{
+			chain.levels.push_back(MipLevel{ w, h, size });
+			size += static_cast<size_t>(w) * h * channelCount;
+			w = std::max(w / 2, 1u);
+			h = std::max(h / 2, 1u);
+		}
+
+		chain.pixels.resize(size);
+		std::memcpy(chain.pixels.data(), pixels, static_cast<size_t>(width) * height * channelCount);
+
+		for (uint32_t level = 1; level < levelCount; ++level)
+		{
+			const auto& source = chain.levels[level - 1];
+			const auto& destination = chain.levels[level];
+			const auto* src = chain.pixels.data() + source.offset;
+			auto* dst = chain.pixels.data() + destination.offset;
+
+			for (uint32_t y = 0; y < destination.height; ++y)
+			{
+				const auto y0 = std::min(y * 2, source.height - 1);
+				const auto y1 = std::min(y * 2 + 1, source.height - 1);
+				for (uint32_t x = 0; x < destination.width; ++x)
+				{
+					const auto x0 = std::min(x * 2, source.width - 1);
+					const auto x1 = std::min(x * 2 + 1, source.width - 1);
+					for (uint32_t c = 0; c < channelCount; ++c)
+					{
+						const uint32_t sum =
+							src[(y0 * source.width + x0) * channelCount + c] +
+							src[(y0 * source.width + x1) * channelCount + c] +
+							src[(y1 * source.width + x0) * channelCount + c] +
+							src[(y1 * source.width + x1) * channelCount + c];
+						dst[(y * destination.width + x) * channelCount + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+		}
+
+		return chain;
+	}
+}
\ No newline at end of file
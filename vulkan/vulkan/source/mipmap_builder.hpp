@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace app
+{
+	struct MipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		size_t offset;
+	};
+
+	//NOTE:8 bit per channel levels packed one after another, level 0 first.
+	struct MipChain
+	{
+		std::vector<uint8_t> pixels;
+		std::vector<MipLevel> levels;
+	};
+
+	//NOTE:CPU side fallback for formats the device can not blit with a linear filter.
+	class MipmapBuilder
+	{
+	public:
+		//NOTE:floor(log2(max(width, height))) + 1, down to a single texel.
+		static uint32_t getLevelCount(uint32_t width, uint32_t height);
+
+		//NOTE:Each level is a 2x2 box filter of the previous one, odd edges clamp.
+		static MipChain build(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t channelCount = 4);
+	};
+}
\ No newline at end of file
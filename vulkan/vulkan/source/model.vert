@@ -1,10 +1,12 @@
 #version 450
-layout(location=0) in vec3 inPosition;
-layout(location=1) in vec3 inColor;
+layout(location=0) in vec4 inPosition;
 layout(location=2) in vec2 inUV;
 
 layout(location=0) out vec2 outUV;
 
+// The colour pass tests depth against what the depth prepass wrote, both must compute the same position bit for bit.
+invariant gl_Position;
+
 layout(binding=0) uniform Matrices
 {
     mat4 world;
@@ -12,9 +14,19 @@ layout(binding=0) uniform Matrices
     mat4 projection;        
 };
 
+layout(push_constant) uniform MeshParameters
+{
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+// True for VertexFormat::Compact, positions are snorm16 relative to the mesh bounds.
+layout(constant_id=2) const bool DEQUANTIZE_POSITION = false;
+
 void main()
 {
+    vec3 position = DEQUANTIZE_POSITION ? positionOffset.xyz + inPosition.xyz * positionScale.xyz : inPosition.xyz;
     mat4 projectionViewWorld = projection * view * world;
-    gl_Position = projectionViewWorld * vec4(inPosition, 1.0);
+    gl_Position = projectionViewWorld * vec4(position, 1.0);
     outUV = inUV;
 }
\ No newline at end of file
@@ -3,240 +3,170 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "stream_reader.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "model_cache.hpp"
+#include "mipmap_builder.hpp"
+#include "ktx_file.hpp"
+#include "texture_importer.hpp"
 #include "stb_image.h"
 
+#include <sstream>
+#include <tuple>
+
 
 namespace app
 {
 	void ModelApp::prepare()
 	{
-		auto modelFilePath = std::filesystem::path("source/alicia-solid.vrm");
-		if (modelFilePath.is_relative())
-		{
-			auto current = std::filesystem::current_path();
-			current /= modelFilePath;
-			current.swap(modelFilePath);
-		}
+		m_threadPool = std::make_unique<ThreadPool>();
 
-		auto reader = std::make_unique<StreamReader>(modelFilePath.parent_path());
-		auto glbStream = reader->GetInputStream(modelFilePath.filename().u8string());
-		auto glbResourceReader = std::make_shared<Microsoft::glTF::GLBResourceReader>(std::move(reader), std::move(glbStream));
-		auto document = Microsoft::glTF::Deserialize(glbResourceReader->GetJson());
+		auto white = std::make_shared<DecodedImage>();
+		white->width = 1;
+		white->height = 1;
+		white->pixels.assign(4, 0xff);
+		m_placeholderTexture = createTextureImage(1, 1, white->format, white->getMipLevelCount());
+		queueTextureUpload(m_placeholderTexture, white);
 
-		makeModelGeometry( document, glbResourceReader);
-		makeModelMaterial(document, glbResourceReader);
+		m_maxTextureArrayLayers = m_physicalDeviceProperties.limits.maxImageArrayLayers;
+
+		m_blockCompressionSupported = m_physicalDeviceFeatures.textureCompressionBC == VK_TRUE;
+		for (auto format : { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK })
+		{
+			VkFormatProperties formatProperties{};
+			vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProperties);
+			m_blockCompressionSupported = m_blockCompressionSupported && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+		}
 
 		prepareUniformBuffers();
 		prepareDescriptorSetLayout();
-		prepareDescriptorPool();
 
-		m_sampler = createSampler();
+		m_samplerCache.initialize(m_physicalDevice, m_device);
 
-		prepareDescriptorSet();
+		const auto isCompact = m_loadOptions.vertexFormat == VertexFormat::Compact;
 
-		VkVertexInputBindingDescription vertexInputBindingDescription
-		{
-			0,
-			sizeof(Vertex),
-			VK_VERTEX_INPUT_RATE_VERTEX
-		};
-
-		std::array<VkVertexInputAttributeDescription, 3> vertexInputAttributeDescriptions
-		{ {
-			{0,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,position)},
-			{1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,color)},
-			{2,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,uv)},
-		} };
-		VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
-		pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-		pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexInputBindingDescription;
-		pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexInputAttributeDescriptions.size();
-		pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInputAttributeDescriptions.data();
-
-		VkViewport viewport
-		{
-			0.0f, static_cast<float>(m_swapchainExtent.height),
-			static_cast<float>(m_swapchainExtent.width), -1.0f * m_swapchainExtent.height,
-			0.0f,1.0f
-		};
+		const auto isSplit = m_loadOptions.splitVertexStreams;
 
-		VkRect2D scissor =
+		//NOTE:Location 1 (color) stays in the Float32 streams for other shaders, the registry strips it since model.vert never reads it.
+		//     The compact formats do not carry it.
+		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
+		if (isSplit)
 		{
-			{0,0},
-			m_swapchainExtent
-		};
-		VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{};
-		pipelineViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		pipelineViewportStateCreateInfo.viewportCount = 1;
-		pipelineViewportStateCreateInfo.pViewports = &viewport;
-		pipelineViewportStateCreateInfo.scissorCount = 1;
-		pipelineViewportStateCreateInfo.pScissors = &scissor;
-
-		VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
-		pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-		VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
-		pipelineRasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		pipelineRasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-		pipelineRasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
-		pipelineRasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		pipelineRasterizationStateCreateInfo.lineWidth = 1.0f;
-
-		VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{};
-		pipelineMultisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		pipelineMultisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCreateInfo.setLayoutCount = 1;
-		pipelineLayoutCreateInfo.pSetLayouts = &m_descriptorSetLayout;
-		vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
-
-		{
-			const auto colorWriteAll =
-				VK_COLOR_COMPONENT_R_BIT |
-				VK_COLOR_COMPONENT_G_BIT |
-				VK_COLOR_COMPONENT_B_BIT |
-				VK_COLOR_COMPONENT_A_BIT;
-			VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-			pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
-			pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-			pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-			pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-			pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-			pipelineColorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
-			pipelineColorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
-			pipelineColorBlendAttachmentState.colorWriteMask = colorWriteAll;
-			VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
-			pipelineColorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-			pipelineColorBlendStateCreateInfo.attachmentCount = 1;
-			pipelineColorBlendStateCreateInfo.pAttachments = &pipelineColorBlendAttachmentState;
-
-			VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{};
-			pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-			pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-			pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-			pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-			pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
-
-			std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos
-			{
-				loadShaderModule("source/model.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
-				loadShaderModule("source/opaque.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+			vertexInputBindingDescriptions =
+			{
+				{0, VertexStreamSplitter::getPositionStride(m_loadOptions.vertexFormat), VK_VERTEX_INPUT_RATE_VERTEX},
+				{1, VertexStreamSplitter::getAttributeStride(m_loadOptions.vertexFormat), VK_VERTEX_INPUT_RATE_VERTEX},
 			};
-
-			VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
-			graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-			graphicsPipelineCreateInfo.stageCount = pipelineShaderStageCreateInfos.size();
-			graphicsPipelineCreateInfo.pStages = pipelineShaderStageCreateInfos.data();
-			graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
-			graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
-			graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
-			graphicsPipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
-			graphicsPipelineCreateInfo.pMultisampleState = &pipelineMultisampleStateCreateInfo;
-			graphicsPipelineCreateInfo.pViewportState = &pipelineViewportStateCreateInfo;
-			graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
-			graphicsPipelineCreateInfo.renderPass = m_renderPass;
-			graphicsPipelineCreateInfo.layout = m_pipelineLayout;
-			vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &m_pipelineOpaque);
-
-
-			for (const auto& shaderStage : pipelineShaderStageCreateInfos)
-			{
-				vkDestroyShaderModule(m_device, shaderStage.module, nullptr);
-			}
-		}
-
-		{
-			const auto colorWriteAll =
-				VK_COLOR_COMPONENT_R_BIT |
-				VK_COLOR_COMPONENT_G_BIT |
-				VK_COLOR_COMPONENT_B_BIT |
-				VK_COLOR_COMPONENT_A_BIT;
-			VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-			pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
-			pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-			pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-			pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-			pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-			pipelineColorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
-			pipelineColorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
-			pipelineColorBlendAttachmentState.colorWriteMask = colorWriteAll;
-			VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
-			pipelineColorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-			pipelineColorBlendStateCreateInfo.attachmentCount = 1;
-			pipelineColorBlendStateCreateInfo.pAttachments = &pipelineColorBlendAttachmentState;
-
-			VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{};
-			pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-			pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-			pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-			pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_FALSE;
-			pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
-
-			std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos
-			{
-				loadShaderModule("source/model.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
-				loadShaderModule("source/alpha.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+			vertexInputAttributeDescriptions =
+			{
+				{0,0,VK_FORMAT_R32G32B32_SFLOAT,0},
+				{1,1,VK_FORMAT_R32G32B32_SFLOAT,offsetof(VertexAttributes,color)},
+				{2,1,VK_FORMAT_R32G32_SFLOAT,offsetof(VertexAttributes,uv)},
 			};
+			if (isCompact)
+			{
+				vertexInputAttributeDescriptions =
+				{
+					{0,0,VK_FORMAT_R16G16B16A16_SNORM,0},
+					{2,1,VK_FORMAT_R16G16_SFLOAT,offsetof(CompactVertexAttributes,uv)},
+				};
+			}
+		}
+		else
+		{
+			vertexInputBindingDescriptions =
+			{
+				{0, static_cast<uint32_t>(isCompact ? sizeof(CompactVertex) : sizeof(Vertex)), VK_VERTEX_INPUT_RATE_VERTEX},
+			};
+			vertexInputAttributeDescriptions =
+			{
+				{0,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,position)},
+				{1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,color)},
+				{2,0,VK_FORMAT_R32G32_SFLOAT,offsetof(Vertex,uv)},
+			};
+			if (isCompact)
+			{
+				vertexInputAttributeDescriptions =
+				{
+					{0,0,VK_FORMAT_R16G16B16A16_SNORM,offsetof(CompactVertex,position)},
+					{2,0,VK_FORMAT_R16G16_SFLOAT,offsetof(CompactVertex,uv)},
+				};
+			}
+		}
 
-			VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
-			graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-			graphicsPipelineCreateInfo.stageCount = pipelineShaderStageCreateInfos.size();
-			graphicsPipelineCreateInfo.pStages = pipelineShaderStageCreateInfos.data();
-			graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
-			graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
-			graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
-			graphicsPipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
-			graphicsPipelineCreateInfo.pMultisampleState = &pipelineMultisampleStateCreateInfo;
-			graphicsPipelineCreateInfo.pViewportState = &pipelineViewportStateCreateInfo;
-			graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
-			graphicsPipelineCreateInfo.renderPass = m_renderPass;
-			graphicsPipelineCreateInfo.layout = m_pipelineLayout;
-			vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &m_pipelineAlpha);
+		//NOTE:Dequantization for the vertex stage, then the texture array layer for the fragment stage, both as the shaders declare them.
+		m_pipelineLayout = SpirvReflection::createPipelineLayout(m_device, m_shaderReflection, { m_descriptorSetLayout });
+
+		m_materialPipelineState.vertexShader = "source/model.vert.spv";
+		m_materialPipelineState.fragmentShader = "source/material.frag.spv";
+		m_materialPipelineState.vertexBindings = vertexInputBindingDescriptions;
+		m_materialPipelineState.vertexAttributes = vertexInputAttributeDescriptions;
+		m_materialPipelineState.layout = m_pipelineLayout;
+		m_materialPipelineState.renderPass = m_renderPass;
+		m_materialPipelineState.setSpecializationConstant(SPECIALIZATION_DEQUANTIZE_POSITION, static_cast<VkBool32>(isCompact ? VK_TRUE : VK_FALSE));
+
+		//NOTE:Depth only passes read the position attribute from binding 0 and nothing else.
+		//     With split streams that binding is the compact position stream. No fragment stage, only depth is written.
+		auto depthPipelineState = m_materialPipelineState;
+		depthPipelineState.vertexShader = "source/depth.vert.spv";
+		depthPipelineState.fragmentShader.clear();
+		depthPipelineState.vertexBindings.resize(1);
+		depthPipelineState.vertexAttributes.resize(1);
+		depthPipelineState.blendMode = BlendMode::None;
+		auto pipelineDepth = m_pipelineRegistry.requestPipeline(depthPipelineState, *m_threadPool);
+
+		//NOTE:The permutations almost every model uses, with the glTF default cutoff. Materials look theirs up while loading,
+		//     so these are requested before the first load to be found in flight rather than compiled twice.
+		const std::array<std::shared_future<VkPipeline>, 3> materialPipelines
+		{
+			m_pipelineRegistry.requestPipeline(getMaterialPipelineState(Microsoft::glTF::ALPHA_OPAQUE, 0.5f), *m_threadPool),
+			m_pipelineRegistry.requestPipeline(getMaterialPipelineState(Microsoft::glTF::ALPHA_MASK, 0.5f), *m_threadPool),
+			m_pipelineRegistry.requestPipeline(getMaterialPipelineState(Microsoft::glTF::ALPHA_BLEND, 0.5f), *m_threadPool),
+		};
 
+		//NOTE:The pipelines compile on the pool alongside the first model load, nothing is drawn before prepare returns.
+		loadModel("source/alicia-solid.vrm");
 
-			for (const auto& shaderStage : pipelineShaderStageCreateInfos)
-			{
-				vkDestroyShaderModule(m_device, shaderStage.module, nullptr);
-			}
+		for (const auto& materialPipeline : materialPipelines)
+		{
+			materialPipeline.wait();
 		}
+		m_pipelineDepth = pipelineDepth.get();
 	}
 
 	void ModelApp::cleanup()
 	{
+		//NOTE:Invalidate the running load first so its late results destroy themselves.
+		++m_loadGeneration;
+		m_threadPool.reset();
+		applyLoadedResources();
+		vkDeviceWaitIdle(m_device);
+
+		if (m_pendingModel)
+		{
+			destroyModel(*m_pendingModel);
+			m_pendingModel.reset();
+		}
+		destroyModel(m_model);
+		destroyTexture(m_placeholderTexture);
+
 		for (auto& uniformBuffer : m_uniformBuffers)
 		{
 			vkDestroyBuffer(m_device, uniformBuffer.buffer, nullptr);
 			vkFreeMemory(m_device, uniformBuffer.deviceMemory, nullptr);
 		}
 
-		vkDestroySampler(m_device, m_sampler, nullptr);
-
-		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-
-		vkDestroyPipeline(m_device, m_pipelineOpaque, nullptr);
-		vkDestroyPipeline(m_device, m_pipelineAlpha, nullptr);
-
-		for (auto&& mesh : m_model.meshes)
+		for (auto& indirectBuffer : m_indirectBuffers)
 		{
-			vkFreeMemory(m_device, mesh.vertexBuffer.deviceMemory, nullptr);
-			vkFreeMemory(m_device, mesh.indexBuffer.deviceMemory, nullptr);
-			vkDestroyBuffer(m_device, mesh.vertexBuffer.buffer, nullptr);
-			vkDestroyBuffer(m_device, mesh.indexBuffer.buffer, nullptr);
-			mesh.descriptorSets.clear();
+			vkDestroyBuffer(m_device, indirectBuffer.buffer, nullptr);
+			vkFreeMemory(m_device, indirectBuffer.deviceMemory, nullptr);
 		}
 
-		for (auto&& material : m_model.materials)
-		{
-			vkFreeMemory(m_device, material.texture.deviceMemory, nullptr);
-			vkDestroyImage(m_device, material.texture.image, nullptr);
-			vkDestroyImageView(m_device, material.texture.imageView, nullptr);
-		}
+		m_samplerCache.destroy();
+
+		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
 
-		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
 
 	}
@@ -247,9 +177,11 @@ namespace app
 
 		UniformParameters uniformParameters{};
 
+		const auto cameraPosition = glm::vec3(0.0f, 1.5f, -1.0f);
+		const auto fovY = glm::radians(45.0f);
 		uniformParameters.matrixWorld = glm::identity<glm::mat4>();
-		uniformParameters.matrixView = glm::lookAtRH(glm::vec3(0.0f, 1.5f, -1.0f), glm::vec3(0.0f, 1.25f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		uniformParameters.matrixProjection = glm::perspective(glm::radians(45.0f), 640.0f / 480, 0.01f, 100.0f);
+		uniformParameters.matrixView = glm::lookAtRH(cameraPosition, glm::vec3(0.0f, 1.25f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		uniformParameters.matrixProjection = glm::perspective(fovY, static_cast<float>(m_swapchainExtent.width) / m_swapchainExtent.height, 0.01f, 100.0f);
 
 		{
 			auto memory = m_uniformBuffers[m_imageIndex].deviceMemory;
@@ -259,46 +191,624 @@ namespace app
 			vkUnmapMemory(m_device, memory);
 		}
 
-		for (auto&& mode : { ALPHA_OPAQUE, ALPHA_MASK, ALPHA_BLEND })
+		selectLods(uniformParameters.matrixWorld, cameraPosition, fovY);
+		updateTextureStreaming(uniformParameters.matrixWorld, cameraPosition, fovY);
+		cullMeshlets(uniformParameters.matrixWorld, uniformParameters.matrixView, uniformParameters.matrixProjection, cameraPosition);
+
+		//NOTE:Every set of this image is written before anything is recorded. Updating a set after the command buffer
+		//     has bound it (the prepass binds one for its uniform buffer) would invalidate the command buffer.
+		for (auto& mesh : m_model.meshes)
 		{
+			updateDescriptorSet(m_model, mesh, m_imageIndex);
+		}
+
+		//NOTE:Only ALPHA_OPAQUE can be laid down without sampling the texture.
+		if (m_loadOptions.depthPrepass)
+		{
+			vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineDepth);
+
+			//NOTE:The depth shader only reads the uniform buffer, which every set of this image shares.
+			auto descriptorSetBound = false;
 			for (auto&& mesh : m_model.meshes)
 			{
-				if (m_model.materials[mesh.materialIndex].alphaMode != mode)
+				if (m_model.materials[mesh.materialIndex].alphaMode != ALPHA_OPAQUE)
 				{
 					continue;
 				}
 
-				switch (mode)
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(command, 0, 1, &mesh.vertexBuffer.buffer, &offset);
+				vkCmdBindIndexBuffer(command, mesh.indexBuffer.buffer, offset, VK_INDEX_TYPE_UINT32);
+				if (!descriptorSetBound)
 				{
-				case ALPHA_OPAQUE:
-				case ALPHA_MASK:
-					vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineOpaque);
-					break;
-				case ALPHA_BLEND:
-					vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineAlpha);
+					vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &mesh.descriptorSets[m_imageIndex], 0, nullptr);
+					descriptorSetBound = true;
+				}
+
+				if (m_loadOptions.vertexFormat == VertexFormat::Compact)
+				{
+					vkCmdPushConstants(command, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PositionDequantization), &mesh.dequantization);
+				}
+
+				drawMesh(command, mesh);
+			}
+		}
+
+		for (auto&& mode : { ALPHA_OPAQUE, ALPHA_MASK, ALPHA_BLEND })
+		{
+			std::vector<ModelMesh*> meshes;
+			for (auto&& mesh : m_model.meshes)
+			{
+				if (m_model.materials[mesh.materialIndex].alphaMode == mode)
+				{
+					meshes.push_back(&mesh);
+				}
+			}
+			if (meshes.empty())
+			{
+				continue;
+			}
+
+			//NOTE:Meshes with the same pipeline (only mask cutoffs tell them apart) sampling the same view with the same sampler
+			//     are drawn back to back on one descriptor set. With packed texture arrays only the layer push constant changes
+			//     between them. Blending keeps model order.
+			if (mode != ALPHA_BLEND)
+			{
+				std::stable_sort(meshes.begin(), meshes.end(), [this](const ModelMesh* a, const ModelMesh* b)
+					{
+						const auto& materialA = m_model.materials[a->materialIndex];
+						const auto& materialB = m_model.materials[b->materialIndex];
+						return std::make_tuple(materialA.pipeline, getImageView(materialA), materialA.sampler) < std::make_tuple(materialB.pipeline, getImageView(materialB), materialB.sampler);
+					});
+			}
+
+			VkPipeline boundPipeline = 0ull;
+			VkImageView boundImageView = 0ull;
+			VkSampler boundSampler = 0ull;
+			for (auto* mesh : meshes)
+			{
+				const auto& material = m_model.materials[mesh->materialIndex];
+
+				if (material.pipeline != boundPipeline)
+				{
+					vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, material.pipeline);
+					boundPipeline = material.pipeline;
+				}
+
+				std::array<VkBuffer, 2> vertexBuffers = { mesh->vertexBuffer.buffer, mesh->attributeBuffer.buffer };
+				std::array<VkDeviceSize, 2> vertexBufferOffsets = { 0, 0 };
+				const auto vertexBufferCount = m_loadOptions.splitVertexStreams ? 2u : 1u;
+				vkCmdBindVertexBuffers(command, 0, vertexBufferCount, vertexBuffers.data(), vertexBufferOffsets.data());
+				vkCmdBindIndexBuffer(command, mesh->indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+				const auto imageView = getImageView(material);
+				if (imageView != boundImageView || material.sampler != boundSampler)
+				{
+					std::array<VkDescriptorSet, 1> descriptorSets =
+					{
+						mesh->descriptorSets[m_imageIndex]
+					};
+					vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, descriptorSets.data(), 0, nullptr);
+					boundImageView = imageView;
+					boundSampler = material.sampler;
+				}
+
+				if (m_loadOptions.vertexFormat == VertexFormat::Compact)
+				{
+					vkCmdPushConstants(command, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PositionDequantization), &mesh->dequantization);
+				}
+				vkCmdPushConstants(command, m_pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(PositionDequantization), sizeof(uint32_t), &material.layer);
+
+				drawMesh(command, *mesh);
+			}
+		}
+
+	}
+
+	void ModelApp::onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced)
+	{
+		auto remap = [&replaced](VkPipeline& pipeline)
+		{
+			auto found = replaced.find(pipeline);
+			if (found != replaced.end())
+			{
+				pipeline = found->second;
+			}
+		};
+
+		remap(m_pipelineDepth);
+		for (auto* model : { &m_model, m_pendingModel.get() })
+		{
+			if (model == nullptr)
+			{
+				continue;
+			}
+			for (auto& material : model->materials)
+			{
+				remap(material.pipeline);
+			}
+		}
+	}
+
+	void ModelApp::onSwapchainImageCountChanged()
+	{
+		for (auto& uniformBuffer : m_uniformBuffers)
+		{
+			vkDestroyBuffer(m_device, uniformBuffer.buffer, nullptr);
+			vkFreeMemory(m_device, uniformBuffer.deviceMemory, nullptr);
+		}
+		prepareUniformBuffers();
+
+		for (auto& indirectBuffer : m_indirectBuffers)
+		{
+			vkDestroyBuffer(m_device, indirectBuffer.buffer, nullptr);
+			vkFreeMemory(m_device, indirectBuffer.deviceMemory, nullptr);
+		}
+		m_indirectBuffers.clear();
+		m_meshletCapacity = 0;
+		prepareIndirectBuffers();
+
+		//NOTE:Sets are allocated per image from a pool sized for the whole model, both are rebuilt for the new count.
+		for (auto* model : { &m_model, m_pendingModel.get() })
+		{
+			if (model == nullptr || model->descriptorPool == 0ull)
+			{
+				continue;
+			}
+			vkDestroyDescriptorPool(m_device, model->descriptorPool, nullptr);
+			prepareDescriptorPool(*model);
+			for (auto& mesh : model->meshes)
+			{
+				prepareDescriptorSet(*model, mesh);
+			}
+		}
+	}
+
+	void ModelApp::selectLods(const glm::mat4& matrixWorld, const glm::vec3& cameraPosition, float fovY)
+	{
+		//NOTE:World units at distance 1 -> pixels.
+		const auto projectionScale = m_swapchainExtent.height / (2.0f * std::tan(fovY * 0.5f));
+		const auto worldScale = std::max(glm::length(glm::vec3(matrixWorld[0])), std::max(glm::length(glm::vec3(matrixWorld[1])), glm::length(glm::vec3(matrixWorld[2]))));
+
+		for (auto&& mesh : m_model.meshes)
+		{
+			mesh.selectedLod = 0;
+			if (mesh.lods.size() <= 1)
+			{
+				continue;
+			}
+
+			//NOTE:Measure from the nearest point of the bounding sphere so the whole mesh stays within the error.
+			const auto center = glm::vec3(matrixWorld * glm::vec4(mesh.boundsCenter, 1.0f));
+			const auto distance = std::max(glm::distance(center, cameraPosition) - mesh.boundsRadius * worldScale, 0.01f);
+
+			for (auto lod = static_cast<uint32_t>(mesh.lods.size()) - 1; lod > 0; --lod)
+			{
+				const auto pixelError = mesh.lods[lod].error * worldScale / distance * projectionScale;
+				if (pixelError <= m_lodPixelError)
+				{
+					mesh.selectedLod = lod;
 					break;
 				}
+			}
+		}
+	}
 
-				VkDeviceSize offset = 0;
-				vkCmdBindVertexBuffers(command, 0, 1, &mesh.vertexBuffer.buffer, &offset);
-				vkCmdBindIndexBuffer(command, mesh.indexBuffer.buffer, offset, VK_INDEX_TYPE_UINT32);
+	void ModelApp::cullMeshlets(const glm::mat4& matrixWorld, const glm::mat4& matrixView, const glm::mat4& matrixProjection, const glm::vec3& cameraPosition)
+	{
+		if (m_meshletCount == 0)
+		{
+			return;
+		}
 
-				std::array<VkDescriptorSet, 1> descriptorSets =
+		//NOTE:Culling happens in model space so the meshlet bounds can be used as they are.
+		const auto frustum = Frustum::fromMatrix(matrixProjection * matrixView * matrixWorld);
+		const auto localCamera = glm::inverse(matrixWorld) * glm::vec4(cameraPosition, 1.0f);
+		const auto localCameraPosition = glm::vec3(localCamera.x, localCamera.y, localCamera.z);
+
+		auto memory = m_indirectBuffers[m_imageIndex].deviceMemory;
+		void* data = nullptr;
+		vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+		auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(data);
+
+		for (auto&& mesh : m_model.meshes)
+		{
+			//NOTE:The rasterizer does not cull, so only single sided materials may drop back facing clusters.
+			const auto cullBackface = !m_model.materials[mesh.materialIndex].doubleSided;
+
+			mesh.visibleMeshletCount = 0;
+
+			//NOTE:Meshlets only cover the full resolution level.
+			if (mesh.selectedLod != 0)
+			{
+				continue;
+			}
+
+			for (const auto& meshlet : mesh.meshlets)
+			{
+				if (!MeshletCuller::isVisible(meshlet, frustum, localCameraPosition, cullBackface))
 				{
-					mesh.descriptorSets[m_imageIndex]
-				};
-				vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, descriptorSets.data(), 0, nullptr);
+					continue;
+				}
+
+				//NOTE:Neighbouring visible meshlets are contiguous in the index buffer, merge them into one draw.
+				if (mesh.visibleMeshletCount > 0)
+				{
+					auto& previous = commands[mesh.meshletOffset + mesh.visibleMeshletCount - 1];
+					if (previous.firstIndex + previous.indexCount == meshlet.firstIndex)
+					{
+						previous.indexCount += meshlet.indexCount;
+						continue;
+					}
+				}
+
+				auto& drawCommand = commands[mesh.meshletOffset + mesh.visibleMeshletCount];
+				drawCommand.indexCount = meshlet.indexCount;
+				drawCommand.instanceCount = 1;
+				drawCommand.firstIndex = meshlet.firstIndex;
+				drawCommand.vertexOffset = 0;
+				drawCommand.firstInstance = 0;
+				++mesh.visibleMeshletCount;
+			}
+		}
+
+		vkUnmapMemory(m_device, memory);
+	}
+
+	void ModelApp::drawMesh(VkCommandBuffer command, const ModelMesh& mesh) const
+	{
+		if (mesh.selectedLod != 0)
+		{
+			const auto& lod = mesh.lods[mesh.selectedLod];
+			vkCmdDrawIndexed(command, lod.indexCount, 1, lod.firstIndex, 0, 0);
+			return;
+		}
+
+		if (mesh.meshlets.empty())
+		{
+			vkCmdDrawIndexed(command, mesh.indexCount, 1, 0, 0, 0);
+			return;
+		}
+
+		if (mesh.visibleMeshletCount == 0)
+		{
+			return;
+		}
+
+		const auto stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+		const auto indirectBuffer = m_indirectBuffers[m_imageIndex].buffer;
+		const VkDeviceSize offset = mesh.meshletOffset * stride;
+
+		if (m_physicalDeviceFeatures.multiDrawIndirect)
+		{
+			vkCmdDrawIndexedIndirect(command, indirectBuffer, offset, mesh.visibleMeshletCount, stride);
+			return;
+		}
+
+		for (auto i = 0u; i < mesh.visibleMeshletCount; ++i)
+		{
+			vkCmdDrawIndexedIndirect(command, indirectBuffer, offset + i * stride, 1, stride);
+		}
+	}
+
+	void ModelApp::loadModel(const std::filesystem::path& modelFilePath)
+	{
+		auto path = modelFilePath;
+		if (path.is_relative())
+		{
+			path = std::filesystem::current_path() / path;
+		}
+
+		const auto generation = ++m_loadGeneration;
+		m_threadPool->enqueue([this, path, generation]() { loadModelAsync(path, generation); });
+	}
+
+	void ModelApp::loadModelAsync(const std::filesystem::path& modelFilePath, uint32_t generation)
+	{
+		using namespace Microsoft::glTF;
+
+		//NOTE:The glTF reader is not thread safe, so every read happens here and only the heavy work fans out.
+		std::vector<Material> materials;
+		std::vector<VkSamplerCreateInfo> samplerCreateInfos;
+		std::vector<std::vector<char>> images;
+		std::vector<MeshData> meshes;
+		auto cached = false;
+		const auto optionsHash = m_loadOptions.hash();
+		try
+		{
+			auto reader = std::make_unique<StreamReader>(modelFilePath.parent_path());
+			auto glbStream = reader->GetInputStream(modelFilePath.filename().u8string());
+			auto glbResourceReader = std::make_shared<GLBResourceReader>(std::move(reader), std::move(glbStream));
+			auto document = Deserialize(glbResourceReader->GetJson());
+
+			for (auto&& materialElement : document.materials.Elements())
+			{
+				auto textureId = materialElement.metallicRoughness.baseColorTexture.textureId;
+				if (textureId.empty())
+				{
+					textureId = materialElement.normalTexture.textureId;
+				}
+
+				auto& texture = document.textures.Get(textureId);
+				auto& image = document.images.Get(texture.imageId);
+				auto imageBufferView = document.bufferViews.Get(image.bufferViewId);
+				images.emplace_back(glbResourceReader->ReadBinaryData<char>(document, imageBufferView));
+				samplerCreateInfos.push_back(getSamplerCreateInfo(texture.samplerId.empty() ? Sampler{} : document.samplers.Get(texture.samplerId)));
+
+				Material material{};
+				material.pipeline = m_pipelineRegistry.getPipeline(getMaterialPipelineState(materialElement.alphaMode, materialElement.alphaCutoff));
+				material.alphaMode = materialElement.alphaMode;
+				material.alphaCutoff = materialElement.alphaCutoff;
+				material.doubleSided = materialElement.doubleSided;
+				materials.push_back(std::move(material));
+			}
+
+			ModelCache cache(modelFilePath);
+			cached = m_loadOptions.useCookedCache && cache.load(optionsHash, meshes);
+			if (!cached)
+			{
+				meshes = loadMeshData(document, glbResourceReader);
+			}
+		}
+		catch (const std::exception& exception)
+		{
+			std::stringstream ss;
+			ss << modelFilePath.u8string() << ": " << exception.what() << std::endl;
+			OutputDebugStringA(ss.str().c_str());
+			return;
+		}
+
+		const auto meshCount = static_cast<uint32_t>(meshes.size());
+		postLoadedResource([this, generation, meshCount, materials, samplerCreateInfos]() mutable
+			{
+				if (generation != m_loadGeneration)
+				{
+					return;
+				}
 
-				vkCmdDrawIndexed(command, mesh.indexCount, 1, 0, 0, 0);
+				for (auto i = 0u; i < materials.size(); ++i)
+				{
+					materials[i].sampler = m_samplerCache.get(samplerCreateInfos[i]);
+					//NOTE:Built by the loader already, this only picks up a hot reload that replaced it since.
+					materials[i].pipeline = m_pipelineRegistry.getPipeline(getMaterialPipelineState(materials[i].alphaMode, materials[i].alphaCutoff));
+				}
+
+				//NOTE:A pending model is never drawn, but its textures may sit in this frame's upload batch.
+				if (m_pendingModel)
+				{
+					auto retiredModel = std::make_shared<Model>(std::move(*m_pendingModel));
+					retireResource([this, retiredModel]() { destroyModel(*retiredModel); });
+				}
+
+				m_pendingModel = std::make_unique<Model>();
+				m_pendingModel->materials = std::move(materials);
+				m_pendingModel->generation = generation;
+				m_pendingModel->meshCount = meshCount;
+				prepareDescriptorPool(*m_pendingModel);
+			});
+
+		//NOTE:Materials whose images have the same bytes share one texture. acquireTexture extends that across models.
+		const auto compressed = m_loadOptions.compressTextures && m_blockCompressionSupported;
+		std::map<uint64_t, MaterialImage> uniqueImages;
+		for (auto i = 0u; i < images.size(); ++i)
+		{
+			const auto key = KtxFile::computeSourceHash(images[i].data(), images[i].size()) ^ (compressed ? TEXTURE_KEY_COMPRESSED : 0ull);
+			auto& uniqueImage = uniqueImages[key];
+			if (!uniqueImage.data)
+			{
+				uniqueImage.data = std::make_shared<const std::vector<char>>(std::move(images[i]));
 			}
+			uniqueImage.materialIndices.push_back(i);
+		}
+
+		{
+			std::stringstream ss;
+			ss << "textures: " << images.size() << " materials -> " << uniqueImages.size() << " images" << std::endl;
+			OutputDebugStringA(ss.str().c_str());
 		}
 
+		if (m_loadOptions.packTextureArrays)
+		{
+			loadTextureArrays(generation, compressed, modelFilePath, uniqueImages);
+		}
+		else
+		{
+			for (auto& [key, uniqueImage] : uniqueImages)
+			{
+				postLoadedResource([this, generation, key = key, compressed, modelFilePath, imageData = uniqueImage.data, materialIndices = uniqueImage.materialIndices]()
+					{
+						auto* model = findModel(generation);
+						if (generation != m_loadGeneration || !model)
+						{
+							return;
+						}
+
+						auto texture = acquireTexture(key, compressed, imageData, modelFilePath);
+						for (auto materialIndex : materialIndices)
+						{
+							model->materials[materialIndex].texture = texture;
+						}
+					});
+			}
+		}
+
+		auto sharedMeshes = std::make_shared<std::vector<MeshData>>(std::move(meshes));
+		auto remainingMeshCount = std::make_shared<std::atomic<uint32_t>>(meshCount);
+		for (auto i = 0u; i < meshCount; ++i)
+		{
+			m_threadPool->enqueue([this, generation, i, cached, optionsHash, modelFilePath, sharedMeshes, remainingMeshCount]()
+				{
+					if (generation != m_loadGeneration)
+					{
+						return;
+					}
+
+					auto& meshData = (*sharedMeshes)[i];
+					if (!cached)
+					{
+						processMeshData(meshData);
+					}
+
+					if (m_loadOptions.weldVertices)
+					{
+						std::stringstream ss;
+						ss << "mesh[" << i << "] welded vertices:" << meshData.sourceVertexCount << "->" << meshData.vertices.size() << std::endl;
+						OutputDebugStringA(ss.str().c_str());
+					}
+
+					if (m_loadOptions.optimizeMeshes)
+					{
+						const auto indexCount = meshData.lods.empty() ? meshData.indices.size() : meshData.lods.front().indexCount;
+						std::stringstream ss;
+						ss << "mesh[" << i << "] vertices:" << meshData.vertices.size() << " triangles:" << indexCount / 3
+							<< " ACMR:" << meshData.sourceStatistics.acmr << "->" << meshData.optimizedStatistics.acmr
+							<< " ATVR:" << meshData.sourceStatistics.atvr << "->" << meshData.optimizedStatistics.atvr << std::endl;
+						OutputDebugStringA(ss.str().c_str());
+					}
+
+					if (meshData.lods.size() > 1)
+					{
+						std::stringstream ss;
+						ss << "mesh[" << i << "] lods:";
+						for (const auto& lod : meshData.lods)
+						{
+							ss << " " << lod.indexCount / 3 << "(" << lod.error << ")";
+						}
+						ss << std::endl;
+						OutputDebugStringA(ss.str().c_str());
+					}
+
+					auto mesh = createModelMesh(meshData);
+					postLoadedResource([this, generation, mesh]() mutable
+						{
+							auto* model = findModel(generation);
+							if (!model)
+							{
+								destroyModelMesh(mesh);
+								return;
+							}
+							addModelMesh(*model, std::move(mesh));
+						});
+
+					//NOTE:The last mesh to finish writes the cooked cache.
+					if (--*remainingMeshCount == 0 && !cached && m_loadOptions.useCookedCache)
+					{
+						ModelCache(modelFilePath).save(optionsHash, *sharedMeshes);
+					}
+				});
+		}
 	}
 
-	void ModelApp::makeModelGeometry(const Microsoft::glTF::Document& document, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader)
+	void ModelApp::processMeshData(MeshData& meshData) const
+	{
+		if (m_loadOptions.weldVertices)
+		{
+			MeshOptimizer::weldVertices(meshData.vertices, meshData.indices, m_loadOptions.weldEpsilon);
+		}
+
+		if (m_loadOptions.optimizeMeshes)
+		{
+			MeshOptimizer::optimize(meshData);
+		}
+
+		if (m_loadOptions.buildMeshlets)
+		{
+			meshData.meshlets = MeshletBuilder::build(meshData);
+		}
+
+		//NOTE:The coarser levels are appended after the meshlets are built, which only index the first level.
+		if (m_loadOptions.generateLods)
+		{
+			MeshSimplifier::generateLods(meshData);
+		}
+		else
+		{
+			MeshSimplifier::computeBounds(meshData);
+		}
+	}
+
+	void ModelApp::applyLoadedResources()
+	{
+		VulkanAppBase::applyLoadedResources();
+
+		//NOTE:Every texture that finished decoding since the last frame goes up in one submission.
+		flushTextureUploads();
+
+		//NOTE:Swap once the new model can be drawn whole, the very first one shows up piece by piece.
+		if (m_pendingModel && (m_model.meshes.empty() || m_pendingModel->meshes.size() == m_pendingModel->meshCount))
+		{
+			auto retiredModel = std::make_shared<Model>(std::move(m_model));
+			retireResource([this, retiredModel]() { destroyModel(*retiredModel); });
+
+			m_model = std::move(*m_pendingModel);
+			m_pendingModel.reset();
+			prepareIndirectBuffers();
+		}
+	}
+
+	ModelApp::Model* ModelApp::findModel(uint32_t generation)
+	{
+		if (m_pendingModel && m_pendingModel->generation == generation)
+		{
+			return m_pendingModel.get();
+		}
+		if (m_model.generation == generation && generation != 0)
+		{
+			return &m_model;
+		}
+		return nullptr;
+	}
+
+	void ModelApp::addModelMesh(Model& model, ModelMesh&& mesh)
+	{
+		prepareDescriptorSet(model, mesh);
+		model.meshes.emplace_back(std::move(mesh));
+
+		if (&model == &m_model)
+		{
+			prepareIndirectBuffers();
+		}
+	}
+
+	void ModelApp::destroyModel(Model& model) const
+	{
+		for (auto&& mesh : model.meshes)
+		{
+			destroyModelMesh(mesh);
+		}
+
+		vkDestroyDescriptorPool(m_device, model.descriptorPool, nullptr);
+
+		model.meshes.clear();
+		model.materials.clear();
+		model.descriptorPool = 0ull;
+	}
+
+	void ModelApp::destroyModelMesh(ModelMesh& mesh) const
+	{
+		vkFreeMemory(m_device, mesh.vertexBuffer.deviceMemory, nullptr);
+		vkFreeMemory(m_device, mesh.attributeBuffer.deviceMemory, nullptr);
+		vkFreeMemory(m_device, mesh.indexBuffer.deviceMemory, nullptr);
+		vkDestroyBuffer(m_device, mesh.vertexBuffer.buffer, nullptr);
+		vkDestroyBuffer(m_device, mesh.attributeBuffer.buffer, nullptr);
+		vkDestroyBuffer(m_device, mesh.indexBuffer.buffer, nullptr);
+		mesh.descriptorSets.clear();
+	}
+
+	void ModelApp::destroyTexture(TextureObject& texture) const
+	{
+		vkDestroyImageView(m_device, texture.imageView, nullptr);
+		vkDestroyImage(m_device, texture.image, nullptr);
+		vkFreeMemory(m_device, texture.deviceMemory, nullptr);
+		texture = TextureObject{};
+	}
+
+	std::vector<MeshData> ModelApp::loadMeshData(const Microsoft::glTF::Document& document, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader) const
 	{
 		using namespace glm;
 		using namespace Microsoft::glTF;
+
+		std::vector<MeshData> meshes;
 		for (auto&& mesh : document.meshes.Elements())
 		{
 			for (auto&& meshPrimitive : mesh.primitives)
@@ -327,109 +837,424 @@ namespace app
 					std::array<uint32_t, 3> threeElementsIds = { 3 * i, 3 * i + 1, 3 * i + 2 };
 					std::array<uint32_t, 2> twoElementsIds = { 2 * i, 2 * i + 1 };
 
-					vertices.emplace_back
-					(
-						Vertex
+					vertices.emplace_back
+					(
+						Vertex
+						{
+							vec3(vertexPosition[threeElementsIds[0]], vertexPosition[threeElementsIds[1]], vertexPosition[threeElementsIds[2]]),
+							vec3(vertexNormal[threeElementsIds[0]], vertexNormal[threeElementsIds[1]], vertexNormal[threeElementsIds[2]]),
+							vec2(vertexUV[twoElementsIds[0]], vertexUV[twoElementsIds[1]])
+						}
+					);
+				}
+
+				MeshData meshData{};
+				meshData.vertices = std::move(vertices);
+				meshData.indices = reader->ReadBinaryData<uint32_t>(document, accessorIndex);
+				meshData.materialIndex = document.materials.GetIndex(meshPrimitive.materialId);
+				meshData.sourceVertexCount = static_cast<uint32_t>(vertexCount);
+
+				meshes.emplace_back(std::move(meshData));
+			}
+		}
+		return meshes;
+	}
+
+	ModelApp::ModelMesh ModelApp::createModelMesh(const MeshData& meshData) const
+	{
+		auto indexBufferSize = sizeof(uint32_t) * meshData.indices.size();
+
+		ModelMesh modelMesh{};
+		modelMesh.dequantization = PositionDequantization{ glm::vec4(0.0f), glm::vec4(1.0f) };
+
+		//NOTE:With split streams vertexBuffer holds the positions and attributeBuffer the rest.
+		const auto createVertexStreams = [&](const VertexStreams& streams)
+		{
+			modelMesh.vertexBuffer = createBuffer(streams.positions.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, streams.positions.data());
+			modelMesh.attributeBuffer = createBuffer(streams.attributes.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, streams.attributes.data());
+		};
+
+		switch (m_loadOptions.vertexFormat)
+		{
+		case VertexFormat::Float32:
+		{
+			if (m_loadOptions.splitVertexStreams)
+			{
+				createVertexStreams(VertexStreamSplitter::split(meshData.vertices));
+				break;
+			}
+			auto vertexBufferSize = sizeof(Vertex) * meshData.vertices.size();
+			modelMesh.vertexBuffer = createBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, meshData.vertices.data());
+			break;
+		}
+		case VertexFormat::Compact:
+		{
+			modelMesh.dequantization = VertexQuantizer::computeDequantization(meshData.vertices);
+			auto compactVertices = VertexQuantizer::quantize(meshData.vertices, modelMesh.dequantization);
+			if (m_loadOptions.splitVertexStreams)
+			{
+				createVertexStreams(VertexStreamSplitter::split(compactVertices));
+				break;
+			}
+			auto vertexBufferSize = sizeof(CompactVertex) * compactVertices.size();
+			modelMesh.vertexBuffer = createBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, compactVertices.data());
+			break;
+		}
+		}
+
+		modelMesh.indexBuffer = createBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, meshData.indices.data());
+		modelMesh.vertexCount = meshData.vertices.size();
+		modelMesh.indexCount = meshData.lods.empty() ? meshData.indices.size() : meshData.lods.front().indexCount;
+		modelMesh.materialIndex = meshData.materialIndex;
+		modelMesh.meshlets = meshData.meshlets;
+		modelMesh.lods = meshData.lods;
+		modelMesh.boundsCenter = meshData.boundsCenter;
+		modelMesh.boundsRadius = meshData.boundsRadius;
+		modelMesh.selectedLod = 0;
+		return modelMesh;
+	}
+
+	ModelApp::BufferObject ModelApp::createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags flags, const void* initialData) const
+	{
+		BufferObject bufferObject{};
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.usage = bufferUsageFlags;
+		bufferCreateInfo.size = size;
+		auto result = vkCreateBuffer(m_device, &bufferCreateInfo, nullptr, &bufferObject.buffer);
+		checkResult(result);
+
+		VkMemoryRequirements memoryRequirements{};
+		vkGetBufferMemoryRequirements(m_device, bufferObject.buffer, &memoryRequirements);
+
+		VkMemoryAllocateInfo memoryAllocateInfo{};
+		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocateInfo.allocationSize = memoryRequirements.size;
+		memoryAllocateInfo.memoryTypeIndex = getMemoryTypeIndex(memoryRequirements.memoryTypeBits, flags);
+		vkAllocateMemory(m_device, &memoryAllocateInfo, nullptr, &bufferObject.deviceMemory);
+
+		vkBindBufferMemory(m_device, bufferObject.buffer, bufferObject.deviceMemory, 0);
+
+		if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 && initialData != nullptr)
+		{
+			void* data = nullptr;
+			vkMapMemory(m_device, bufferObject.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data);
+			memcpy(data, initialData, size);
+			vkUnmapMemory(m_device, bufferObject.deviceMemory);
+		}
+
+		return bufferObject;
+
+	}
+
+	ModelApp::TextureHandle ModelApp::findTexture(uint64_t key) const
+	{
+		auto found = m_textureCache.find(key);
+		return found != m_textureCache.end() ? found->second.lock() : TextureHandle{};
+	}
+
+	ModelApp::TextureHandle ModelApp::makeTextureHandle(uint64_t key)
+	{
+		//NOTE:Models are only ever destroyed once no frame can use them, so the last reference can free the texture right away.
+		TextureHandle texture(new CachedTexture{ key }, [this](CachedTexture* cachedTexture)
+			{
+				if (cachedTexture->texture.image != 0ull)
+				{
+					destroyTexture(cachedTexture->texture);
+				}
+				auto found = m_textureCache.find(cachedTexture->key);
+				if (found != m_textureCache.end() && found->second.expired())
+				{
+					m_textureCache.erase(found);
+				}
+				delete cachedTexture;
+			});
+		m_textureCache[key] = texture;
+		return texture;
+	}
+
+	ModelApp::TextureHandle ModelApp::acquireTexture(uint64_t key, bool compressed, std::shared_ptr<const std::vector<char>> imageData, const std::filesystem::path& modelFilePath)
+	{
+		if (auto texture = findTexture(key))
+		{
+			return texture;
+		}
+
+		auto texture = makeTextureHandle(key);
+		const auto cookedPath = getCookedTexturePath(modelFilePath, key);
+
+		std::weak_ptr<CachedTexture> weakTexture = texture;
+		m_threadPool->enqueue([this, weakTexture, compressed, imageData, cookedPath]()
+			{
+				if (weakTexture.expired())
+				{
+					return;
+				}
+
+				//NOTE:Only the decode runs here, images and uploads are created on the render thread.
+				//     Streaming uploads levels out of the CPU copy, so it needs the whole chain up front.
+				auto image = std::make_shared<DecodedImage>(loadImage(compressed, *imageData, cookedPath, m_loadOptions.streamTextures));
+				if (image->pixels.empty())
+				{
+					return;
+				}
+
+				postLoadedResource([this, weakTexture, image]()
+					{
+						auto texture = weakTexture.lock();
+						if (!texture)
+						{
+							return;
+						}
+
+						//NOTE:Streamed textures start from their small tail, updateTextureStreaming brings the rest in.
+						if (m_loadOptions.streamTextures)
+						{
+							texture->source = image;
+							texture->residentLevel = getStreamingTailLevel(*image);
+						}
+
+						//NOTE:Descriptor sets of every material sharing it pick the new view up as their frames come around.
+						const auto& baseLevel = image->levels.empty() ? MipLevel{ image->width, image->height, 0 } : image->levels[texture->residentLevel];
+						texture->texture = createTextureImage(baseLevel.width, baseLevel.height, image->format, image->getMipLevelCount() - texture->residentLevel);
+						queueTextureUpload(texture->texture, image, texture->residentLevel);
+					});
+			});
+
+		return texture;
+	}
+
+	void ModelApp::loadTextureArrays(uint32_t generation, bool compressed, const std::filesystem::path& modelFilePath, const std::map<uint64_t, MaterialImage>& images)
+	{
+		struct DecodedLayer
+		{
+			uint64_t key;
+			std::vector<uint32_t> materialIndices;
+			std::shared_ptr<const DecodedImage> image;
+		};
+
+		//NOTE:Layers are decoded in parallel, the last one to finish sorts them into arrays.
+		auto layers = std::make_shared<std::vector<DecodedLayer>>();
+		for (const auto& [key, image] : images)
+		{
+			layers->push_back(DecodedLayer{ key, image.materialIndices });
+		}
+
+		auto remainingLayerCount = std::make_shared<std::atomic<uint32_t>>(static_cast<uint32_t>(layers->size()));
+		auto i = 0u;
+		for (const auto& [key, image] : images)
+		{
+			m_threadPool->enqueue([this, generation, compressed, i, imageData = image.data, cookedPath = getCookedTexturePath(modelFilePath, key), layers, remainingLayerCount]()
+				{
+					if (generation == m_loadGeneration)
+					{
+						(*layers)[i].image = std::make_shared<DecodedImage>(loadImage(compressed, *imageData, cookedPath, true));
+					}
+
+					if (--*remainingLayerCount != 0 || generation != m_loadGeneration)
+					{
+						return;
+					}
+
+					//NOTE:Layers of one array need the same format, size and level count.
+					std::map<std::tuple<VkFormat, uint32_t, uint32_t, uint32_t>, std::vector<const DecodedLayer*>> groups;
+					for (const auto& layer : *layers)
+					{
+						if (layer.image && !layer.image->pixels.empty())
 						{
-							vec3(vertexPosition[threeElementsIds[0]], vertexPosition[threeElementsIds[1]], vertexPosition[threeElementsIds[2]]),
-							vec3(vertexNormal[threeElementsIds[0]], vertexNormal[threeElementsIds[1]], vertexNormal[threeElementsIds[2]]),
-							vec2(vertexUV[twoElementsIds[0]], vertexUV[twoElementsIds[1]])
+							const auto& decodedImage = *layer.image;
+							groups[{ decodedImage.format, decodedImage.width, decodedImage.height, decodedImage.getMipLevelCount() }].push_back(&layer);
 						}
-					);
-				}
+					}
 
-				std::vector<uint32_t> indices = reader->ReadBinaryData<uint32_t>(document, accessorIndex);
-
-				auto vertexBufferSize = sizeof(Vertex) * vertices.size();
-				auto indexBufferSize = sizeof(uint32_t) * indices.size();
-
-				ModelMesh modelMesh{};
-				modelMesh.vertexBuffer = createBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, vertices.data());
-				modelMesh.indexBuffer = createBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, indices.data());
-				modelMesh.vertexCount = vertices.size();
-				modelMesh.indexCount = indices.size();
-				modelMesh.materialIndex = document.materials.GetIndex(meshPrimitive.materialId);
+					auto arrayCount = 0u;
+					for (const auto& [description, group] : groups)
+					{
+						for (size_t first = 0; first < group.size(); first += m_maxTextureArrayLayers)
+						{
+							const auto last = std::min(group.size(), first + m_maxTextureArrayLayers);
+
+							auto key = TEXTURE_KEY_ARRAY;
+							std::vector<std::shared_ptr<const DecodedImage>> arrayLayers;
+							std::vector<std::vector<uint32_t>> materialIndices;
+							for (auto layer = first; layer < last; ++layer)
+							{
+								key = (key ^ group[layer]->key) * 0x100000001b3ull;
+								arrayLayers.push_back(group[layer]->image);
+								materialIndices.push_back(group[layer]->materialIndices);
+							}
+
+							auto arrayImage = std::make_shared<const DecodedImage>(packLayers(arrayLayers));
+							postLoadedResource([this, generation, key, arrayImage, materialIndices]()
+								{
+									auto* model = findModel(generation);
+									if (generation != m_loadGeneration || !model)
+									{
+										return;
+									}
+
+									auto texture = findTexture(key);
+									if (!texture)
+									{
+										texture = makeTextureHandle(key);
+										texture->texture = createTextureImage(arrayImage->width, arrayImage->height, arrayImage->format, arrayImage->getMipLevelCount(), arrayImage->layerCount);
+										queueTextureUpload(texture->texture, arrayImage);
+									}
+
+									for (auto layer = 0u; layer < materialIndices.size(); ++layer)
+									{
+										for (auto materialIndex : materialIndices[layer])
+										{
+											model->materials[materialIndex].texture = texture;
+											model->materials[materialIndex].layer = layer;
+										}
+									}
+								});
+							++arrayCount;
+						}
+					}
 
-				m_model.meshes.emplace_back(std::move(modelMesh));
-			}
+					std::stringstream ss;
+					ss << "texture arrays: " << layers->size() << " images -> " << arrayCount << " arrays" << std::endl;
+					OutputDebugStringA(ss.str().c_str());
+				});
+			++i;
 		}
 	}
 
-	void ModelApp::makeModelMaterial(const Microsoft::glTF::Document& document, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader)
+	ModelApp::DecodedImage ModelApp::packLayers(const std::vector<std::shared_ptr<const DecodedImage>>& layers)
 	{
-		for (auto&& materialElement : document.materials.Elements())
+		const auto& first = *layers.front();
+
+		DecodedImage packed{};
+		packed.width = first.width;
+		packed.height = first.height;
+		packed.format = first.format;
+		packed.channelCount = first.channelCount;
+		packed.layerCount = static_cast<uint32_t>(layers.size());
+		packed.pixels.reserve(first.pixels.size() * layers.size());
+
+		for (size_t level = 0; level < first.levels.size(); ++level)
 		{
-			auto textureId = materialElement.metallicRoughness.baseColorTexture.textureId;
-			if (textureId.empty())
+			const auto offset = first.levels[level].offset;
+			const auto size = (level + 1 < first.levels.size() ? first.levels[level + 1].offset : first.pixels.size()) - offset;
+
+			packed.levels.push_back(MipLevel{ first.levels[level].width, first.levels[level].height, packed.pixels.size() });
+			for (const auto& layer : layers)
 			{
-				textureId = materialElement.normalTexture.textureId;
+				packed.pixels.insert(packed.pixels.end(), layer->pixels.begin() + offset, layer->pixels.begin() + offset + size);
 			}
+		}
 
-			auto& texture = document.textures.Get(textureId);
-			auto& image = document.images.Get(texture.imageId);
-			auto imageBufferView = document.bufferViews.Get(image.bufferViewId);
-			auto imageData = reader->ReadBinaryData<char>(document, imageBufferView);
+		return packed;
+	}
 
-			Material material{};
-			material.alphaMode = materialElement.alphaMode;
-			material.texture = createTextureFromMemory(imageData);
-			m_model.materials.push_back(std::move(material));
-		}
+	std::filesystem::path ModelApp::getCookedTexturePath(const std::filesystem::path& modelFilePath, uint64_t key)
+	{
+		std::stringstream ss;
+		ss << modelFilePath.filename().u8string() << "." << std::hex << key << ".ktx2";
+		return modelFilePath.parent_path() / std::filesystem::u8path(ss.str());
 	}
 
-	ModelApp::BufferObject ModelApp::createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags flags, const void* initialData) const
+	VkImageView ModelApp::getImageView(const Material& material) const
 	{
-		BufferObject bufferObject{};
+		return material.texture && material.texture->texture.imageView != 0ull ? material.texture->texture.imageView : m_placeholderTexture.imageView;
+	}
 
-		VkBufferCreateInfo bufferCreateInfo{};
-		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferCreateInfo.usage = bufferUsageFlags;
-		bufferCreateInfo.size = size;
-		auto result = vkCreateBuffer(m_device, &bufferCreateInfo, nullptr, &bufferObject.buffer);
-		checkResult(result);
+	ModelApp::DecodedImage ModelApp::decodeImage(const std::vector<char>& imageData) const
+	{
+		DecodedImage decodedImage{};
 
-		VkMemoryRequirements memoryRequirements{};
-		vkGetBufferMemoryRequirements(m_device, bufferObject.buffer, &memoryRequirements);
+		int width = 0, height = 0, channels = 0;
+		auto* const image = stbi_load_from_memory(reinterpret_cast<const uint8_t*>(imageData.data()), imageData.size(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!image)
+		{
+			OutputDebugStringA("failed to decode texture.\n");
+			return decodedImage;
+		}
 
-		VkMemoryAllocateInfo memoryAllocateInfo{};
-		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memoryAllocateInfo.allocationSize = memoryRequirements.size;
-		memoryAllocateInfo.memoryTypeIndex = getMemoryTypeIndex(memoryRequirements.memoryTypeBits, flags);
-		vkAllocateMemory(m_device, &memoryAllocateInfo, nullptr, &bufferObject.deviceMemory);
+		decodedImage.width = static_cast<uint32_t>(width);
+		decodedImage.height = static_cast<uint32_t>(height);
+		decodedImage.pixels.assign(image, image + width * height * 4);
+		stbi_image_free(image);
+		return decodedImage;
+	}
 
-		vkBindBufferMemory(m_device, bufferObject.buffer, bufferObject.deviceMemory, 0);
+	ModelApp::DecodedImage ModelApp::importImage(const std::vector<char>& imageData) const
+	{
+		auto decodedImage = decodeImage(imageData);
+		if (decodedImage.pixels.empty())
+		{
+			return decodedImage;
+		}
 
-		if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 && initialData != nullptr)
+		//NOTE:sRGB formats only when the swapchain encodes on write, otherwise the colors would be linearized twice.
+		const auto srgb = m_surfaceFormat.format == VK_FORMAT_B8G8R8A8_SRGB || m_surfaceFormat.format == VK_FORMAT_R8G8B8A8_SRGB;
+		auto imported = TextureImporter::import(decodedImage.pixels.data(), decodedImage.width, decodedImage.height, srgb);
+		decodedImage.format = static_cast<VkFormat>(imported.vkFormat);
+		decodedImage.channelCount = imported.channelCount;
+		decodedImage.pixels = std::move(imported.pixels);
+		return decodedImage;
+	}
+
+	ModelApp::DecodedImage ModelApp::cookImage(const std::vector<char>& imageData, const std::filesystem::path& cookedPath) const
+	{
+		const auto sourceHash = KtxFile::computeSourceHash(imageData.data(), imageData.size()) ^ TextureCompressor::VERSION;
+		KtxFile ktxFile(cookedPath);
+
+		TextureData texture{};
+		if (!m_loadOptions.useCookedCache || !ktxFile.load(sourceHash, texture))
 		{
-			void* data = nullptr;
-			vkMapMemory(m_device, bufferObject.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data);
-			memcpy(data, initialData, size);
-			vkUnmapMemory(m_device, bufferObject.deviceMemory);
+			auto decodedImage = decodeImage(imageData);
+			if (decodedImage.pixels.empty())
+			{
+				return decodedImage;
+			}
+
+			texture = TextureCompressor::compress(MipmapBuilder::build(decodedImage.width, decodedImage.height, decodedImage.pixels.data()));
+			if (m_loadOptions.useCookedCache)
+			{
+				ktxFile.save(sourceHash, texture);
+			}
 		}
 
-		return bufferObject;
+		DecodedImage decodedImage{};
+		decodedImage.width = texture.mips.levels.front().width;
+		decodedImage.height = texture.mips.levels.front().height;
+		decodedImage.format = static_cast<VkFormat>(texture.vkFormat);
+		decodedImage.pixels = std::move(texture.mips.pixels);
+		decodedImage.levels = std::move(texture.mips.levels);
+		return decodedImage;
+	}
 
+	ModelApp::DecodedImage ModelApp::loadImage(bool compressed, const std::vector<char>& imageData, const std::filesystem::path& cookedPath, bool buildMipChain) const
+	{
+		auto image = compressed ? cookImage(imageData, cookedPath) : importImage(imageData);
+		if (buildMipChain && !image.pixels.empty() && image.levels.empty())
+		{
+			auto chain = MipmapBuilder::build(image.width, image.height, image.pixels.data(), image.channelCount);
+			image.pixels = std::move(chain.pixels);
+			image.levels = std::move(chain.levels);
+		}
+		return image;
 	}
 
-	ModelApp::TextureObject ModelApp::createTextureFromMemory(const std::vector<char>& imageData) const
+	ModelApp::TextureObject ModelApp::createTextureImage(uint32_t width, uint32_t height, VkFormat format, uint32_t mipLevels, uint32_t layerCount) const
 	{
-		BufferObject stagingBuffer{};
 		TextureObject textureObject{};
-
-		int width = 0, height = 0, channels = 0;
-		auto* const image = stbi_load_from_memory( reinterpret_cast<const uint8_t*>(imageData.data()), imageData.size(), &width, &height, &channels, 0);
-		auto format = VK_FORMAT_R8G8B8A8_UNORM;
+		textureObject.format = format;
 
 		{
 			VkImageCreateInfo imageCreateInfo{};
 			imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			imageCreateInfo.extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+			imageCreateInfo.extent = { width, height, 1 };
 			imageCreateInfo.format = format;
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-			imageCreateInfo.arrayLayers = 1;
-			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.arrayLayers = layerCount;
+			imageCreateInfo.mipLevels = mipLevels;
 			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			vkCreateImage(m_device, &imageCreateInfo, nullptr, &textureObject.image);
 
 			VkMemoryRequirements memoryRequirements{};
@@ -443,17 +1268,173 @@ namespace app
 		}
 
 		{
-			uint32_t imageSize = width * height * sizeof(uint32_t);
-			stagingBuffer = createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, image);
-			void* data = nullptr;
-			vkMapMemory(m_device, stagingBuffer.deviceMemory, 0, VK_WHOLE_SIZE, 0, &data);
-			memcpy(data, image, imageSize);
-			vkUnmapMemory(m_device, stagingBuffer.deviceMemory);
+			VkImageViewCreateInfo imageViewCreateInfo{};
+			imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			//NOTE:Always an array view, the shaders sample every texture as sampler2DArray.
+			imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+			imageViewCreateInfo.image = textureObject.image;
+			imageViewCreateInfo.format = format;
+			imageViewCreateInfo.components = {
+				VK_COMPONENT_SWIZZLE_R,
+				VK_COMPONENT_SWIZZLE_G,
+				VK_COMPONENT_SWIZZLE_B,
+				VK_COMPONENT_SWIZZLE_A,
+			};
+			//NOTE:Narrow formats from TextureImporter hold grey in R and alpha in G, shaders still see RGBA.
+			switch (format)
+			{
+			case VK_FORMAT_R8_UNORM:
+			case VK_FORMAT_R8_SRGB:
+				imageViewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+				break;
+			case VK_FORMAT_R8G8_UNORM:
+			case VK_FORMAT_R8G8_SRGB:
+				imageViewCreateInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G };
+				break;
+			default:
+				break;
+			}
+			imageViewCreateInfo.subresourceRange = {
+				VK_IMAGE_ASPECT_COLOR_BIT,0,mipLevels,0,layerCount
+			};
+			vkCreateImageView(m_device, &imageViewCreateInfo, nullptr, &textureObject.imageView);
+		}
+
+		return textureObject;
+	}
+
+	void ModelApp::queueTextureUpload(const TextureObject& texture, std::shared_ptr<const DecodedImage> image, uint32_t firstLevel)
+	{
+		m_textureUploads.push_back(TextureUpload{ texture, std::move(image), firstLevel });
+	}
+
+	uint32_t ModelApp::getStreamingTailLevel(const DecodedImage& image)
+	{
+		const auto levelCount = image.getMipLevelCount();
+		auto level = 0u;
+		while (level + 1 < levelCount && std::max(image.width >> level, image.height >> level) > STREAMING_TAIL_SIZE)
+		{
+			++level;
+		}
+		return level;
+	}
+
+	uint64_t ModelApp::getResidentSize(const DecodedImage& image, uint32_t firstLevel)
+	{
+		return image.pixels.size() - image.levels[firstLevel].offset;
+	}
+
+	void ModelApp::updateTextureStreaming(const glm::mat4& matrixWorld, const glm::vec3& cameraPosition, float fovY)
+	{
+		if (!m_loadOptions.streamTextures)
+		{
+			return;
+		}
+
+		struct StreamingState
+		{
+			TextureHandle texture;
+			uint32_t tailLevel;
+			uint32_t wantedLevel;
+		};
+
+		std::unordered_map<CachedTexture*, StreamingState> states;
+		for (const auto& [key, weakTexture] : m_textureCache)
+		{
+			auto texture = weakTexture.lock();
+			if (texture && texture->source)
+			{
+				const auto tailLevel = getStreamingTailLevel(*texture->source);
+				states.emplace(texture.get(), StreamingState{ texture, tailLevel, tailLevel });
+			}
+		}
+
+		//NOTE:Assume a texture spans its mesh, so one texel per pixel of the bounding sphere's screen diameter.
+		const auto projectionScale = m_swapchainExtent.height / (2.0f * std::tan(fovY * 0.5f));
+		const auto worldScale = std::max(glm::length(glm::vec3(matrixWorld[0])), std::max(glm::length(glm::vec3(matrixWorld[1])), glm::length(glm::vec3(matrixWorld[2]))));
+		for (const auto& mesh : m_model.meshes)
+		{
+			const auto found = states.find(m_model.materials[mesh.materialIndex].texture.get());
+			if (found == states.end())
+			{
+				continue;
+			}
+
+			auto& state = found->second;
+			const auto center = glm::vec3(matrixWorld * glm::vec4(mesh.boundsCenter, 1.0f));
+			const auto distance = std::max(glm::distance(center, cameraPosition) - mesh.boundsRadius * worldScale, 0.01f);
+			const auto coverage = std::max(2.0f * mesh.boundsRadius * worldScale / distance * projectionScale, 1.0f);
+
+			const auto& source = *state.texture->source;
+			const auto level = std::max(std::floor(std::log2(std::max(source.width, source.height) / coverage)), 0.0f);
+			state.wantedLevel = std::min(state.wantedLevel, static_cast<uint32_t>(level));
+		}
+
+		//NOTE:Over budget, the most detailed wanted level gives way first. The tails always stay.
+		uint64_t wantedSize = 0;
+		for (const auto& [texture, state] : states)
+		{
+			wantedSize += getResidentSize(*state.texture->source, state.wantedLevel);
+		}
+		while (wantedSize > m_textureBudget)
+		{
+			StreamingState* largest = nullptr;
+			for (auto& [texture, state] : states)
+			{
+				if (state.wantedLevel < state.tailLevel && (!largest || getResidentSize(*state.texture->source, state.wantedLevel) > getResidentSize(*largest->texture->source, largest->wantedLevel)))
+				{
+					largest = &state;
+				}
+			}
+			if (!largest)
+			{
+				break;
+			}
+
+			const auto& source = *largest->texture->source;
+			wantedSize -= getResidentSize(source, largest->wantedLevel) - getResidentSize(source, largest->wantedLevel + 1);
+			++largest->wantedLevel;
+		}
+
+		//NOTE:Eviction happens at once, streaming in goes one level per texture per frame within STREAMING_UPLOAD_LIMIT.
+		uint64_t uploadSize = 0;
+		for (auto& [cachedTexture, state] : states)
+		{
+			auto& texture = *state.texture;
+			const auto& source = *texture.source;
+
+			auto level = texture.residentLevel;
+			if (state.wantedLevel > level)
+			{
+				level = state.wantedLevel;
+			}
+			else if (state.wantedLevel < level && uploadSize + getResidentSize(source, level - 1) <= STREAMING_UPLOAD_LIMIT)
+			{
+				level = level - 1;
+				uploadSize += getResidentSize(source, level);
+			}
+
+			if (level != texture.residentLevel)
+			{
+				auto retiredTexture = texture.texture;
+				retireResource([this, retiredTexture]() mutable { destroyTexture(retiredTexture); });
+
+				texture.texture = createTextureImage(source.levels[level].width, source.levels[level].height, source.format, source.getMipLevelCount() - level);
+				texture.residentLevel = level;
+				queueTextureUpload(texture.texture, texture.source, level);
+			}
+		}
+
+		flushTextureUploads();
+	}
+
+	void ModelApp::flushTextureUploads()
+	{
+		if (m_textureUploads.empty())
+		{
+			return;
 		}
 
-		VkBufferImageCopy copyRegion{};
-		copyRegion.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
-		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,0,0,1 };
 		VkCommandBuffer commandBuffer = nullptr;
 		{
 			VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
@@ -466,64 +1447,178 @@ namespace app
 
 		VkCommandBufferBeginInfo commandBufferBeginInfo{};
 		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
-		setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
 
-		setImageMemoryBarrier(commandBuffer, textureObject.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		auto stagingBuffers = std::make_shared<std::vector<BufferObject>>();
+		for (const auto& upload : m_textureUploads)
+		{
+			const auto& image = *upload.image;
+			const auto mipLevels = image.getMipLevelCount() - upload.firstLevel;
+
+			setImageMemoryBarrier(commandBuffer, upload.texture.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+
+			if (image.levels.empty() && isLinearBlitSupported(image.format))
+			{
+				auto stagingBuffer = createBuffer(static_cast<uint32_t>(image.pixels.size()), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, image.pixels.data());
+				stagingBuffers->push_back(stagingBuffer);
+
+				VkBufferImageCopy copyRegion{};
+				copyRegion.imageExtent = { image.width, image.height, 1 };
+				copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,0,0,1 };
+				vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, upload.texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+				generateMipmaps(commandBuffer, upload.texture.image, image.width, image.height, mipLevels);
+			}
+			else
+			{
+				//NOTE:Cooked textures carry their whole chain, uncompressed ones get one built here.
+				MipChain chain{};
+				if (image.levels.empty())
+				{
+					chain = MipmapBuilder::build(image.width, image.height, image.pixels.data(), image.channelCount);
+				}
+				const auto& pixels = image.levels.empty() ? chain.pixels : image.pixels;
+				const auto& levels = image.levels.empty() ? chain.levels : image.levels;
+
+				//NOTE:Levels are packed largest first, so a streamed range is just the tail of the data.
+				const auto baseOffset = levels[upload.firstLevel].offset;
+				auto stagingBuffer = createBuffer(static_cast<uint32_t>(pixels.size() - baseOffset), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, pixels.data() + baseOffset);
+				stagingBuffers->push_back(stagingBuffer);
+
+				std::vector<VkBufferImageCopy> copyRegions;
+				for (auto level = upload.firstLevel; level < levels.size(); ++level)
+				{
+					const auto& mipLevel = levels[level];
+					VkBufferImageCopy copyRegion{};
+					copyRegion.bufferOffset = mipLevel.offset - baseOffset;
+					copyRegion.imageExtent = { mipLevel.width, mipLevel.height, 1 };
+					copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,level - upload.firstLevel,0,image.layerCount };
+					copyRegions.push_back(copyRegion);
+				}
+				vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, upload.texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+				setImageMemoryBarrier(commandBuffer, upload.texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+			}
+		}
 		vkEndCommandBuffer(commandBuffer);
 
+		//NOTE:Submitted ahead of the frame being recorded, the barriers above order it before any sampling.
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
-		vkQueueSubmit(m_deviceQueue, 1, &submitInfo, VK_NULL_HANDLE);
 		{
-			VkImageViewCreateInfo imageViewCreateInfo{};
-			imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			imageViewCreateInfo.image = textureObject.image;
-			imageViewCreateInfo.format = format;
-			imageViewCreateInfo.components = {
-				VK_COMPONENT_SWIZZLE_R,
-				VK_COMPONENT_SWIZZLE_G,
-				VK_COMPONENT_SWIZZLE_B,
-				VK_COMPONENT_SWIZZLE_A,
-			};
-			imageViewCreateInfo.subresourceRange = {
-				VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1
-			};
-			vkCreateImageView(m_device, &imageViewCreateInfo, nullptr, &textureObject.imageView);
+			std::lock_guard<std::mutex> queueLock(m_queueMutex);
+			vkQueueSubmit(m_deviceQueue, 1, &submitInfo, VK_NULL_HANDLE);
 		}
 
-		vkDeviceWaitIdle(m_device);
-		vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
-
-		vkFreeMemory(m_device, stagingBuffer.deviceMemory, nullptr);
-		vkDestroyBuffer(m_device, stagingBuffer.buffer, nullptr);
-
-		stbi_image_free(image);
-
-		return textureObject;
+		retireResource([this, commandBuffer, stagingBuffers]()
+			{
+				vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+				for (auto& stagingBuffer : *stagingBuffers)
+				{
+					vkFreeMemory(m_device, stagingBuffer.deviceMemory, nullptr);
+					vkDestroyBuffer(m_device, stagingBuffer.buffer, nullptr);
+				}
+			});
 
+		m_textureUploads.clear();
 	}
 
-	VkSampler ModelApp::createSampler() const
+	VkSamplerCreateInfo ModelApp::getSamplerCreateInfo(const Microsoft::glTF::Sampler& sampler) const
 	{
-		VkSampler sampler = 0ull;
+		using namespace Microsoft::glTF;
+
+		auto getAddressMode = [](WrapMode wrapMode)
+		{
+			switch (wrapMode)
+			{
+			case Wrap_CLAMP_TO_EDGE:
+				return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+			case Wrap_MIRRORED_REPEAT:
+				return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+			default:
+				return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			}
+		};
+
 		VkSamplerCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		createInfo.magFilter = sampler.magFilter.HasValue() && sampler.magFilter.Get() == MagFilter_NEAREST ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
 		createInfo.minFilter = VK_FILTER_LINEAR;
-		createInfo.magFilter = VK_FILTER_LINEAR;
-		createInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		createInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		createInfo.addressModeU = getAddressMode(sampler.wrapS);
+		createInfo.addressModeV = getAddressMode(sampler.wrapT);
+		createInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		createInfo.minLod = 0.0f;
+		createInfo.maxLod = VK_LOD_CLAMP_NONE;
 		createInfo.maxAnisotropy = 1.0f;
 		createInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-		vkCreateSampler(m_device, &createInfo, nullptr, &sampler);
-		return sampler;
+
+		//NOTE:Unset means the renderer's choice, which is trilinear.
+		//     Filters without mipmaps sample level 0 only, maxLod 0.25 is how the spec emulates them.
+		switch (sampler.minFilter.HasValue() ? sampler.minFilter.Get() : MinFilter_LINEAR_MIPMAP_LINEAR)
+		{
+		case MinFilter_NEAREST:
+			createInfo.minFilter = VK_FILTER_NEAREST;
+			createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			createInfo.maxLod = 0.25f;
+			break;
+		case MinFilter_LINEAR:
+			createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			createInfo.maxLod = 0.25f;
+			break;
+		case MinFilter_NEAREST_MIPMAP_NEAREST:
+			createInfo.minFilter = VK_FILTER_NEAREST;
+			createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			break;
+		case MinFilter_LINEAR_MIPMAP_NEAREST:
+			createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+			break;
+		case MinFilter_NEAREST_MIPMAP_LINEAR:
+			createInfo.minFilter = VK_FILTER_NEAREST;
+			break;
+		default:
+			break;
+		}
+
+		//NOTE:Nearest and unmipmapped samplers are asked for to look blocky or to be cheap, anisotropy would defeat both.
+		if (createInfo.minFilter == VK_FILTER_LINEAR && createInfo.maxLod == VK_LOD_CLAMP_NONE && m_loadOptions.maxAnisotropy > 1.0f)
+		{
+			createInfo.anisotropyEnable = VK_TRUE;
+			createInfo.maxAnisotropy = m_loadOptions.maxAnisotropy;
+		}
+		return createInfo;
 	}
 
-	void ModelApp::setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) const
+	PipelineState ModelApp::getMaterialPipelineState(Microsoft::glTF::AlphaMode alphaMode, float alphaCutoff) const
+	{
+		using namespace Microsoft::glTF;
+
+		//NOTE:ALPHA_MODE of material.frag, 0:opaque 1:mask 2:blend.
+		auto state = m_materialPipelineState;
+		uint32_t shaderAlphaMode = 0;
+		switch (alphaMode)
+		{
+		case ALPHA_MASK:
+			shaderAlphaMode = 1;
+			break;
+		case ALPHA_BLEND:
+			shaderAlphaMode = 2;
+			state.blendMode = BlendMode::Alpha;
+			state.depthWrite = false;
+			break;
+		default:
+			break;
+		}
+		state.setSpecializationConstant(SPECIALIZATION_ALPHA_MODE, shaderAlphaMode);
+		//NOTE:The other modes never read the cutoff, a fixed value keeps them to one pipeline each.
+		state.setSpecializationConstant(SPECIALIZATION_ALPHA_CUTOFF, alphaMode == ALPHA_MASK ? alphaCutoff : 0.5f);
+		return state;
+	}
+
+	void ModelApp::setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) const
 	{
 		VkImageMemoryBarrier imageMemoryBarrier{};
 		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -531,7 +1626,7 @@ namespace app
 		imageMemoryBarrier.newLayout = newLayout;
 		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,0,1,0,1 };
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,0,mipLevels,0,VK_REMAINING_ARRAY_LAYERS };
 		imageMemoryBarrier.image = image;
 
 		VkPipelineStageFlags srcStageFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
@@ -557,6 +1652,7 @@ namespace app
 		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
 			imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
 		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
 			imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -579,90 +1675,84 @@ namespace app
 
 	}
 
-	VkPipelineShaderStageCreateInfo ModelApp::loadShaderModule(std::string_view fileName, VkShaderStageFlagBits stage)
+	void ModelApp::prepareUniformBuffers()
 	{
-		std::ifstream infile(fileName.data(), std::ios::binary);
-
-		if (!infile)
+		m_uniformBuffers.resize(m_swapchainImageViews.size());
+		for (auto& uniformBuffer : m_uniformBuffers)
 		{
-			OutputDebugStringA(fileName.data());
-			OutputDebugStringA("file not found.\n");
-			DebugBreak();
+			VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			uniformBuffer = createBuffer(sizeof(UniformParameters), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, flags);
 		}
+	}
 
-		std::vector<char>filedata;
-		filedata.resize(static_cast<uint32_t>(infile.seekg(0, std::ifstream::end).tellg()));
-		infile.seekg(0, std::ifstream::beg).read(filedata.data(), filedata.size());
-
-		VkShaderModule shaderModule = 0ull;
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = reinterpret_cast<uint32_t*>(filedata.data());
-		shaderModuleCreateInfo.codeSize = filedata.size();
-		vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &shaderModule);
-
-		VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
-		pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		pipelineShaderStageCreateInfo.stage = stage;
-		pipelineShaderStageCreateInfo.module = shaderModule;
-		pipelineShaderStageCreateInfo.pName = "main";
+	void ModelApp::prepareIndirectBuffers()
+	{
+		m_meshletCount = 0;
+		for (auto&& mesh : m_model.meshes)
+		{
+			mesh.meshletOffset = m_meshletCount;
+			mesh.visibleMeshletCount = 0;
+			m_meshletCount += static_cast<uint32_t>(mesh.meshlets.size());
+		}
 
-		return pipelineShaderStageCreateInfo;
+		if (m_meshletCount <= m_meshletCapacity)
+		{
+			return;
+		}
 
+		//NOTE:Frames in flight may still read the old buffers.
+		auto retiredBuffers = std::make_shared<std::vector<BufferObject>>(std::move(m_indirectBuffers));
+		retireResource([this, retiredBuffers]()
+			{
+				for (auto& indirectBuffer : *retiredBuffers)
+				{
+					vkDestroyBuffer(m_device, indirectBuffer.buffer, nullptr);
+					vkFreeMemory(m_device, indirectBuffer.deviceMemory, nullptr);
+				}
+			});
 
-	}
+		m_meshletCapacity = std::max(m_meshletCount, m_meshletCapacity * 2);
 
-	void ModelApp::prepareUniformBuffers()
-	{
-		m_uniformBuffers.resize(m_swapchainImageViews.size());
-		for (auto& uniformBuffer : m_uniformBuffers)
+		m_indirectBuffers.clear();
+		m_indirectBuffers.resize(m_swapchainImageViews.size());
+		for (auto& indirectBuffer : m_indirectBuffers)
 		{
 			VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-			uniformBuffer = createBuffer(sizeof(UniformParameters), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, flags);
+			indirectBuffer = createBuffer(sizeof(VkDrawIndexedIndirectCommand) * m_meshletCapacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, flags);
 		}
 	}
 
 	void ModelApp::prepareDescriptorSetLayout()
 	{
-		std::vector<VkDescriptorSetLayoutBinding>bindings;
-		VkDescriptorSetLayoutBinding bindingUniformBuffer{}, bindingTexture{};
-		bindingUniformBuffer.binding = 0;
-		bindingUniformBuffer.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		bindingUniformBuffer.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		bindingUniformBuffer.descriptorCount = 1;
-		bindings.emplace_back(std::move(bindingUniformBuffer));
+		m_shaderReflection = reflectShaders({ "source/model.vert.spv", "source/depth.vert.spv", "source/material.frag.spv" });
 
-		bindingTexture.binding = 1;
-		bindingTexture.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		bindingTexture.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		bindingTexture.descriptorCount = 1;
-		bindings.emplace_back(std::move(bindingTexture));
-
-		VkDescriptorSetLayoutCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		createInfo.bindingCount = bindings.size();
-		createInfo.pBindings = bindings.data();
-		vkCreateDescriptorSetLayout(m_device, &createInfo, nullptr, &m_descriptorSetLayout);
+		//NOTE:Everything is bound through set 0.
+		const auto setLayouts = SpirvReflection::createDescriptorSetLayouts(m_device, m_shaderReflection);
+		if (setLayouts.size() != 1)
+		{
+			DebugBreak();
+			return;
+		}
+		m_descriptorSetLayout = setLayouts.front();
 	}
 
-	void ModelApp::prepareDescriptorPool()
+	void ModelApp::prepareDescriptorPool(Model& model)
 	{
-		std::array<VkDescriptorPoolSize, 2> descriptorPoolSize;
-		descriptorPoolSize[0].descriptorCount = m_swapchainImageViews.size();
-		descriptorPoolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorPoolSize[1].descriptorCount = m_swapchainImageViews.size();
-		descriptorPoolSize[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		//NOTE:Meshes arrive one by one, so the pool is sized for the whole model up front.
+		const auto setCount = std::max(1u, static_cast<uint32_t>(m_swapchainImageViews.size()) * model.meshCount);
+
+		const auto descriptorPoolSize = SpirvReflection::getDescriptorPoolSizes(m_shaderReflection, 0, setCount);
 
 		VkDescriptorPoolCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		createInfo.maxSets = m_swapchainImageViews.size() * m_model.meshes.size();
-		createInfo.poolSizeCount = descriptorPoolSize.size();
+		createInfo.maxSets = setCount;
+		createInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSize.size());
 		createInfo.pPoolSizes = descriptorPoolSize.data();
-		vkCreateDescriptorPool(m_device, &createInfo, nullptr, &m_descriptorPool);
+		vkCreateDescriptorPool(m_device, &createInfo, nullptr, &model.descriptorPool);
 
 	}
 
-	void ModelApp::prepareDescriptorSet()
+	void ModelApp::prepareDescriptorSet(const Model& model, ModelMesh& mesh)
 	{
 		std::vector<VkDescriptorSetLayout>descriptorSetLayouts;
 		for (auto i = 0u; i < m_swapchainImageViews.size(); i++)
@@ -670,18 +1760,18 @@ namespace app
 			descriptorSetLayouts.push_back(m_descriptorSetLayout);
 		}
 
-		for (auto&& mesh : m_model.meshes)
 		{
 			VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
 			descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			descriptorSetAllocateInfo.descriptorPool = m_descriptorPool;
+			descriptorSetAllocateInfo.descriptorPool = model.descriptorPool;
 			descriptorSetAllocateInfo.descriptorSetCount = m_swapchainImageViews.size();
 			descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts.data();
 
 			mesh.descriptorSets.resize(m_swapchainImageViews.size());
 			vkAllocateDescriptorSets(m_device, &descriptorSetAllocateInfo, mesh.descriptorSets.data());
 
-			auto material = m_model.materials[mesh.materialIndex];
+			const auto imageView = getImageView(model.materials[mesh.materialIndex]);
+			mesh.boundImageViews.assign(m_swapchainImageViews.size(), imageView);
 
 			for (auto i = 0u; i < m_swapchainImageViews.size(); i++)
 			{
@@ -692,8 +1782,8 @@ namespace app
 				descriptorBufferInfo.range = VK_WHOLE_SIZE;
 
 				VkDescriptorImageInfo descriptorImageInfo{};
-				descriptorImageInfo.imageView = material.texture.imageView;
-				descriptorImageInfo.sampler = m_sampler;
+				descriptorImageInfo.imageView = imageView;
+				descriptorImageInfo.sampler = model.materials[mesh.materialIndex].sampler;
 				descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 				VkWriteDescriptorSet uniformBufferWriteDescriptorSet{};
@@ -724,4 +1814,30 @@ namespace app
 
 
 	}
+
+	void ModelApp::updateDescriptorSet(const Model& model, ModelMesh& mesh, uint32_t imageIndex)
+	{
+		//NOTE:Only the set of the image being recorded is rewritten, the others may still be in flight.
+		const auto imageView = getImageView(model.materials[mesh.materialIndex]);
+		if (mesh.boundImageViews[imageIndex] == imageView)
+		{
+			return;
+		}
+
+		VkDescriptorImageInfo descriptorImageInfo{};
+		descriptorImageInfo.imageView = imageView;
+		descriptorImageInfo.sampler = model.materials[mesh.materialIndex].sampler;
+		descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet textureWriteDescriptorSet{};
+		textureWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		textureWriteDescriptorSet.dstBinding = 1;
+		textureWriteDescriptorSet.descriptorCount = 1;
+		textureWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		textureWriteDescriptorSet.pImageInfo = &descriptorImageInfo;
+		textureWriteDescriptorSet.dstSet = mesh.descriptorSets[imageIndex];
+		vkUpdateDescriptorSets(m_device, 1, &textureWriteDescriptorSet, 0, nullptr);
+
+		mesh.boundImageViews[imageIndex] = imageView;
+	}
 }
\ No newline at end of file
@@ -1,8 +1,22 @@
 #pragma once
 
 #include "vulkan_app_base.hpp"
+#include "mesh_data.hpp"
+#include "vertex_format.hpp"
+#include "meshlet.hpp"
+#include "thread_pool.hpp"
+#include "mipmap_builder.hpp"
+#include "sampler_cache.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "glm/glm.hpp"
 #include "GLTFSDK/GLTF.h"
@@ -19,11 +33,47 @@ namespace app
 	{
 	public:
 
-		struct Vertex
+		using Vertex = ModelVertex;
+
+		struct LoadOptions
 		{
-			glm::vec3 position;
-			glm::vec3 color;
-			glm::vec2 uv;
+			bool optimizeMeshes = true;
+			bool buildMeshlets = true;
+			bool generateLods = true;
+			bool weldVertices = true;
+			//NOTE:0 only welds bit-identical vertices.
+			float weldEpsilon = 0.0f;
+			bool useCookedCache = true;
+			VertexFormat vertexFormat = VertexFormat::Float32;
+			//NOTE:Positions in binding 0, everything else in binding 1.
+			bool splitVertexStreams = true;
+			//NOTE:Lays down ALPHA_OPAQUE depth from the position stream before the color pass.
+			bool depthPrepass = false;
+
+			//NOTE:BC1/BC3 with mips, cooked to "<model>.<content hash>.ktx2". Falls back to RGBA8 without textureCompressionBC.
+			bool compressTextures = true;
+			//NOTE:Keep a CPU copy of every chain and only the mips the screen coverage asks for resident, see updateTextureStreaming.
+			bool streamTextures = true;
+			//NOTE:Applied to mipmapped linear glTF samplers, clamped to the device limit. 1 disables it.
+			float maxAnisotropy = 8.0f;
+			//NOTE:Material textures of the same size and format become layers of one 2D array, see loadTextureArrays.
+			//     Arrays are fully resident, so streamTextures does not apply to them.
+			bool packTextureArrays = false;
+
+			//NOTE:Only options that change the cooked data take part in the hash.
+			//     Cooked textures are keyed by their source bytes instead.
+			uint32_t hash() const
+			{
+				uint32_t epsilonBits = 0;
+				std::memcpy(&epsilonBits, &weldEpsilon, sizeof(epsilonBits));
+
+				const auto flags =
+					(optimizeMeshes ? 1u << 0 : 0u) |
+					(buildMeshlets ? 1u << 1 : 0u) |
+					(generateLods ? 1u << 2 : 0u) |
+					(weldVertices ? 1u << 3 : 0u);
+				return flags | (weldVertices ? (epsilonBits * 2654435761u) & ~0xffu : 0u);
+			}
 		};
 
 		struct BufferObject
@@ -37,28 +87,99 @@ namespace app
 			VkImage image;
 			VkDeviceMemory deviceMemory;
 			VkImageView imageView;
+			VkFormat format;
+		};
+
+		//NOTE:Pixels prepared on a loader thread. levels is empty when pixels only hold level 0
+		//     and the chain is generated on upload, otherwise it describes every level packed in pixels.
+		//     channelCount is the texel size of uncompressed formats (R8, RG8 or RGBA8).
+		//     Texture arrays store the layers of a level one after another, offsets point at layer 0.
+		struct DecodedImage
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+			uint32_t channelCount = 4;
+			uint32_t layerCount = 1;
+			std::vector<uint8_t> pixels;
+			std::vector<MipLevel> levels;
+
+			uint32_t getMipLevelCount() const
+			{
+				return levels.empty() ? MipmapBuilder::getLevelCount(width, height) : static_cast<uint32_t>(levels.size());
+			}
+		};
+
+		struct TextureUpload
+		{
+			TextureObject texture;
+			std::shared_ptr<const DecodedImage> image;
+			//NOTE:Level of image that becomes level 0 of texture.
+			uint32_t firstLevel = 0;
 		};
 
 		struct ModelMesh
 		{
 			BufferObject vertexBuffer;
+			BufferObject attributeBuffer;
 			BufferObject indexBuffer;
 			uint32_t vertexCount;
 			uint32_t indexCount;
 			int materialIndex;
+			PositionDequantization dequantization;
+			std::vector<Meshlet> meshlets;
+			uint32_t meshletOffset;
+			uint32_t visibleMeshletCount;
+			std::vector<MeshLod> lods;
+			glm::vec3 boundsCenter;
+			float boundsRadius;
+			uint32_t selectedLod;
 			std::vector<VkDescriptorSet> descriptorSets;
+			//NOTE:Texture each descriptor set was last written with, per swapchain image.
+			std::vector<VkImageView> boundImageViews;
+		};
+
+		//NOTE:One per distinct image content. image stays null until the decode has come back.
+		struct CachedTexture
+		{
+			uint64_t key;
+			TextureObject texture{};
+			//NOTE:Streamed textures only: the whole chain on the CPU and the first level texture holds.
+			std::shared_ptr<const DecodedImage> source;
+			uint32_t residentLevel = 0;
+		};
+		using TextureHandle = std::shared_ptr<CachedTexture>;
+
+		//NOTE:Encoded image bytes shared by every material listed.
+		struct MaterialImage
+		{
+			std::shared_ptr<const std::vector<char>> data;
+			std::vector<uint32_t> materialIndices;
 		};
 
 		struct Material
 		{
-			TextureObject texture;
+			//NOTE:Shared between materials and models with identical images, see acquireTexture.
+			TextureHandle texture;
+			//NOTE:Owned by m_samplerCache.
+			VkSampler sampler;
+			//NOTE:Owned by m_pipelineRegistry, see getMaterialPipelineState.
+			VkPipeline pipeline;
+			//NOTE:Layer of texture, pushed per draw. Only packed texture arrays have more than one.
+			uint32_t layer;
 			Microsoft::glTF::AlphaMode alphaMode;
+			float alphaCutoff;
+			bool doubleSided;
 		};
 
+		//NOTE:Meshes and textures arrive from the loader threads in any order.
 		struct Model
 		{
 			std::vector<ModelMesh> meshes;
 			std::vector<Material> materials;
+			uint32_t generation = 0;
+			uint32_t meshCount = 0;
+			VkDescriptorPool descriptorPool = 0ull;
 		};
 
 		struct UniformParameters
@@ -69,40 +190,117 @@ namespace app
 		};
 
 		ModelApp() : VulkanAppBase() {}
+		explicit ModelApp(const LoadOptions& loadOptions) : VulkanAppBase(), m_loadOptions(loadOptions) {}
 
 		virtual void prepare() override;
 		virtual void cleanup() override;
 		virtual void makeCommand(VkCommandBuffer command) override;
+		virtual void onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced) override;
+		virtual void onSwapchainImageCountChanged() override;
+
+		//NOTE:Loads in the background; the current model keeps drawing until the new one has all of its geometry.
+		void loadModel(const std::filesystem::path& modelFilePath);
 
 	private:
-		void makeModelGeometry(const Microsoft::glTF::Document&, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader);
-		void makeModelMaterial(const Microsoft::glTF::Document&, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader);
+		void loadModelAsync(const std::filesystem::path& modelFilePath, uint32_t generation);
+		void processMeshData(MeshData& meshData) const;
+		std::vector<MeshData> loadMeshData(const Microsoft::glTF::Document&, std::shared_ptr<Microsoft::glTF::GLTFResourceReader> reader) const;
+		ModelMesh createModelMesh(const MeshData& meshData) const;
 
-		BufferObject createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags flags, const void* initialData = nullptr) const;
-		TextureObject createTextureFromMemory(const std::vector<char>& imageData)const;
-		VkSampler createSampler()const;
+		//NOTE:Also uploads the textures decoded since the last frame and swaps in a pending model that is complete.
+		virtual void applyLoadedResources() override;
+		Model* findModel(uint32_t generation);
+		void addModelMesh(Model& model, ModelMesh&& mesh);
+		void destroyModel(Model& model) const;
+		void destroyModelMesh(ModelMesh& mesh) const;
+		void destroyTexture(TextureObject& texture) const;
 
-		void setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) const;
+		BufferObject createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags, VkMemoryPropertyFlags flags, const void* initialData = nullptr) const;
+		TextureHandle findTexture(uint64_t key) const;
+		TextureHandle makeTextureHandle(uint64_t key);
+		TextureHandle acquireTexture(uint64_t key, bool compressed, std::shared_ptr<const std::vector<char>> imageData, const std::filesystem::path& modelFilePath);
+		void loadTextureArrays(uint32_t generation, bool compressed, const std::filesystem::path& modelFilePath, const std::map<uint64_t, MaterialImage>& images);
+		static DecodedImage packLayers(const std::vector<std::shared_ptr<const DecodedImage>>& layers);
+		static std::filesystem::path getCookedTexturePath(const std::filesystem::path& modelFilePath, uint64_t key);
+		VkImageView getImageView(const Material& material) const;
+		DecodedImage decodeImage(const std::vector<char>& imageData)const;
+		DecodedImage importImage(const std::vector<char>& imageData)const;
+		DecodedImage cookImage(const std::vector<char>& imageData, const std::filesystem::path& cookedPath)const;
+		DecodedImage loadImage(bool compressed, const std::vector<char>& imageData, const std::filesystem::path& cookedPath, bool buildMipChain)const;
+		TextureObject createTextureImage(uint32_t width, uint32_t height, VkFormat format, uint32_t mipLevels, uint32_t layerCount = 1)const;
+		void queueTextureUpload(const TextureObject& texture, std::shared_ptr<const DecodedImage> image, uint32_t firstLevel = 0);
+		void updateTextureStreaming(const glm::mat4& matrixWorld, const glm::vec3& cameraPosition, float fovY);
+		static uint32_t getStreamingTailLevel(const DecodedImage& image);
+		static uint64_t getResidentSize(const DecodedImage& image, uint32_t firstLevel);
+		void flushTextureUploads();
+		VkSamplerCreateInfo getSamplerCreateInfo(const Microsoft::glTF::Sampler& sampler)const;
+		//NOTE:Safe on the loader threads. alphaCutoff only takes part for ALPHA_MASK.
+		PipelineState getMaterialPipelineState(Microsoft::glTF::AlphaMode alphaMode, float alphaCutoff) const;
 
-		VkPipelineShaderStageCreateInfo loadShaderModule(std::string_view fileName, VkShaderStageFlagBits stage);
+		void setImageMemoryBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1) const;
 
 		void prepareUniformBuffers();
+		void prepareIndirectBuffers();
 		void prepareDescriptorSetLayout();
-		void prepareDescriptorPool();
-		void prepareDescriptorSet();
+		void prepareDescriptorPool(Model& model);
+		void prepareDescriptorSet(const Model& model, ModelMesh& mesh);
+		void updateDescriptorSet(const Model& model, ModelMesh& mesh, uint32_t imageIndex);
+
+		void selectLods(const glm::mat4& matrixWorld, const glm::vec3& cameraPosition, float fovY);
+		void cullMeshlets(const glm::mat4& matrixWorld, const glm::mat4& matrixView, const glm::mat4& matrixProjection, const glm::vec3& cameraPosition);
+		void drawMesh(VkCommandBuffer command, const ModelMesh& mesh) const;
 
 
+		LoadOptions m_loadOptions{};
 		Model m_model{};
+		std::unique_ptr<Model> m_pendingModel;
+
+		std::unique_ptr<ThreadPool> m_threadPool;
+		std::atomic<uint32_t> m_loadGeneration{ 0 };
+
+		//NOTE:Bound to materials whose texture is still loading.
+		TextureObject m_placeholderTexture{};
+		//NOTE:Keyed by image content hash, with the encoding folded in (TEXTURE_KEY_COMPRESSED).
+		//     Samplers are bound per material, so they are not part of the key.
+		static constexpr uint64_t TEXTURE_KEY_COMPRESSED = 0x9e3779b97f4a7c15ull;
+		//NOTE:Seed of the key of a packed array, which folds in the keys of its layers in order.
+		static constexpr uint64_t TEXTURE_KEY_ARRAY = 0xc2b2ae3d27d4eb4full;
+		std::unordered_map<uint64_t, std::weak_ptr<CachedTexture>> m_textureCache;
+
+		//NOTE:Levels up to this size are resident from the start and never evicted.
+		static constexpr uint32_t STREAMING_TAIL_SIZE = 64;
+		static constexpr uint64_t STREAMING_UPLOAD_LIMIT = 16ull << 20;
+		uint64_t m_textureBudget = 256ull << 20;
+		bool m_blockCompressionSupported = false;
+		uint32_t m_maxTextureArrayLayers = 1;
+		//NOTE:Recorded into a single command buffer once per frame, see flushTextureUploads.
+		std::vector<TextureUpload> m_textureUploads;
 
 		std::vector<BufferObject> m_uniformBuffers;
 
+		//NOTE:One VkDrawIndexedIndirectCommand slot per meshlet of every mesh, per swapchain image.
+		std::vector<BufferObject> m_indirectBuffers;
+		uint32_t m_meshletCount = 0;
+		uint32_t m_meshletCapacity = 0;
+
+		//NOTE:Coarser levels are used while their error projects below this many pixels.
+		float m_lodPixelError = 1.0f;
+
+		//NOTE:model.vert, depth.vert and material.frag merged. The set layout, pipeline layout and pool sizes come from it.
+		ShaderReflection m_shaderReflection;
 		VkDescriptorSetLayout m_descriptorSetLayout = 0ull;
-		VkDescriptorPool m_descriptorPool = 0ull;
 
-		VkSampler m_sampler = 0ull;
+		//NOTE:glTF samplers with the same state share a VkSampler across materials and models.
+		SamplerCache m_samplerCache;
 
 		VkPipelineLayout m_pipelineLayout = 0ull;
-		VkPipeline m_pipelineOpaque = 0ull;
-		VkPipeline m_pipelineAlpha = 0ull;
+		//NOTE:Owned by m_pipelineRegistry.
+		VkPipeline m_pipelineDepth = 0ull;
+		//NOTE:Everything but the alpha constants, filled in prepare before the first load.
+		PipelineState m_materialPipelineState;
+		//NOTE:constant_id values of model.vert, depth.vert and material.frag.
+		static constexpr uint32_t SPECIALIZATION_ALPHA_MODE = 0;
+		static constexpr uint32_t SPECIALIZATION_ALPHA_CUTOFF = 1;
+		static constexpr uint32_t SPECIALIZATION_DEQUANTIZE_POSITION = 2;
 	};
 }
\ No newline at end of file
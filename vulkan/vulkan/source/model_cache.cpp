@@ -0,0 +1,170 @@
+#include "model_cache.hpp"
+
+#include <fstream>
+
+namespace app
+{
+	namespace
+	{
+		template<typename T>
+		void writeValue(std::ostream& stream, const T& value)
+		{
+			stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		void writeVector(std::ostream& stream, const std::vector<T>& values)
+		{
+			writeValue(stream, static_cast<uint32_t>(values.size()));
+			stream.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+		}
+
+		template<typename T>
+		bool readValue(std::istream& stream, T& value)
+		{
+			stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+			return static_cast<bool>(stream);
+		}
+
+		template<typename T>
+		bool readVector(std::istream& stream, std::vector<T>& values)
+		{
+			uint32_t count = 0;
+			if (!readValue(stream, count))
+			{
+				return false;
+			}
+			values.resize(count);
+			stream.read(reinterpret_cast<char*>(values.data()), sizeof(T) * values.size());
+			return static_cast<bool>(stream);
+		}
+	}
+
+	ModelCache::ModelCache(std::filesystem::path sourcePath) :
+		m_sourcePath(std::move(sourcePath))
+	{
+		m_cookedPath = m_sourcePath;
+		m_cookedPath += ".cooked";
+	}
+
+	bool ModelCache::load(uint32_t optionsHash, std::vector<MeshData>& meshes) const
+	{
+		std::ifstream stream(m_cookedPath, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+
+		Header expected{}, header{};
+		if (!makeHeader(optionsHash, 0, expected) || !readValue(stream, header))
+		{
+			return false;
+		}
+
+		if (
+			header.magic != expected.magic ||
+			header.version != expected.version ||
+			header.sourceSize != expected.sourceSize ||
+			header.sourceTime != expected.sourceTime ||
+			header.optionsHash != expected.optionsHash
+			)
+		{
+			return false;
+		}
+
+		std::vector<MeshData> result(header.meshCount);
+		for (auto& mesh : result)
+		{
+			int32_t materialIndex = 0;
+			if (
+				!readValue(stream, materialIndex) ||
+				!readValue(stream, mesh.sourceVertexCount) ||
+				!readValue(stream, mesh.sourceStatistics) ||
+				!readValue(stream, mesh.optimizedStatistics) ||
+				!readVector(stream, mesh.vertices) ||
+				!readVector(stream, mesh.indices) ||
+				!readVector(stream, mesh.meshlets) ||
+				!readVector(stream, mesh.lods) ||
+				!readValue(stream, mesh.boundsCenter) ||
+				!readValue(stream, mesh.boundsRadius)
+				)
+			{
+				return false;
+			}
+			mesh.materialIndex = materialIndex;
+		}
+
+		meshes.swap(result);
+		return true;
+	}
+
+	void ModelCache::save(uint32_t optionsHash, const std::vector<MeshData>& meshes) const
+	{
+		Header header{};
+		if (!makeHeader(optionsHash, static_cast<uint32_t>(meshes.size()), header))
+		{
+			return;
+		}
+
+		//NOTE:Write to a temporary file first so a crash never leaves a truncated cache behind.
+		auto temporaryPath = m_cookedPath;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return;
+			}
+
+			writeValue(stream, header);
+			for (const auto& mesh : meshes)
+			{
+				writeValue(stream, static_cast<int32_t>(mesh.materialIndex));
+				writeValue(stream, mesh.sourceVertexCount);
+				writeValue(stream, mesh.sourceStatistics);
+				writeValue(stream, mesh.optimizedStatistics);
+				writeVector(stream, mesh.vertices);
+				writeVector(stream, mesh.indices);
+				writeVector(stream, mesh.meshlets);
+				writeVector(stream, mesh.lods);
+				writeValue(stream, mesh.boundsCenter);
+				writeValue(stream, mesh.boundsRadius);
+			}
+
+			if (!stream)
+			{
+				return;
+			}
+		}
+
+		std::error_code errorCode;
+		std::filesystem::rename(temporaryPath, m_cookedPath, errorCode);
+		if (errorCode)
+		{
+			std::filesystem::remove(temporaryPath, errorCode);
+		}
+	}
+
+	bool ModelCache::makeHeader(uint32_t optionsHash, uint32_t meshCount, Header& header) const
+	{
+		std::error_code errorCode;
+		const auto sourceSize = std::filesystem::file_size(m_sourcePath, errorCode);
+		if (errorCode)
+		{
+			return false;
+		}
+		const auto sourceTime = std::filesystem::last_write_time(m_sourcePath, errorCode);
+		if (errorCode)
+		{
+			return false;
+		}
+
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceSize = sourceSize;
+		header.sourceTime = static_cast<int64_t>(sourceTime.time_since_epoch().count());
+		header.optionsHash = optionsHash;
+		header.meshCount = meshCount;
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+#include <filesystem>
+
+namespace app
+{
+	//NOTE:Cooked geometry is stored next to the source model as "<model>.cooked".
+	//     It is invalidated when the source file or the load options change.
+	class ModelCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x434d4b56; // "VKMC"
+		static constexpr uint32_t VERSION = 5;
+
+		explicit ModelCache(std::filesystem::path sourcePath);
+
+		bool load(uint32_t optionsHash, std::vector<MeshData>& meshes) const;
+		void save(uint32_t optionsHash, const std::vector<MeshData>& meshes) const;
+
+		const std::filesystem::path& getCookedPath() const { return m_cookedPath; }
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			uint32_t optionsHash;
+			uint32_t meshCount;
+		};
+
+		bool makeHeader(uint32_t optionsHash, uint32_t meshCount, Header& header) const;
+
+		std::filesystem::path m_sourcePath;
+		std::filesystem::path m_cookedPath;
+	};
+}
\ No newline at end of file
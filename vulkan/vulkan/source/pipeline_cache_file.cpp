@@ -0,0 +1,140 @@
+#include "pipeline_cache_file.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace app
+{
+	namespace
+	{
+		uint64_t computeHash(const std::vector<uint8_t>& data)
+		{
+			//NOTE:FNV-1a, enough to catch a truncated or partially written file.
+			auto hash = 0xcbf29ce484222325ull;
+			for (auto byte : data)
+			{
+				hash = (hash ^ byte) * 0x100000001b3ull;
+			}
+			return hash;
+		}
+	}
+
+	PipelineCacheFile::PipelineCacheFile(std::filesystem::path path) :
+		m_path(std::move(path))
+	{
+	}
+
+	bool PipelineCacheFile::load(const VkPhysicalDeviceProperties& properties, std::vector<uint8_t>& data) const
+	{
+		std::ifstream stream(m_path, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+
+		Header header{};
+		if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		{
+			return false;
+		}
+
+		const auto expected = makeHeader(properties, {});
+		if (
+			header.magic != expected.magic ||
+			header.version != expected.version ||
+			header.vendorID != expected.vendorID ||
+			header.deviceID != expected.deviceID ||
+			header.driverVersion != expected.driverVersion ||
+			std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0
+			)
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> result(static_cast<size_t>(header.dataSize));
+		if (!stream.read(reinterpret_cast<char*>(result.data()), result.size()))
+		{
+			return false;
+		}
+
+		if (computeHash(result) != header.dataHash || !isCompatible(properties, result))
+		{
+			return false;
+		}
+
+		data.swap(result);
+		return true;
+	}
+
+	void PipelineCacheFile::save(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data) const
+	{
+		if (data.empty())
+		{
+			return;
+		}
+
+		//NOTE:Write to a temporary file first so a crash never leaves a truncated cache behind.
+		auto temporaryPath = m_path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return;
+			}
+
+			const auto header = makeHeader(properties, data);
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+			if (!stream)
+			{
+				return;
+			}
+		}
+
+		std::error_code errorCode;
+		std::filesystem::rename(temporaryPath, m_path, errorCode);
+		if (errorCode)
+		{
+			std::filesystem::remove(temporaryPath, errorCode);
+		}
+	}
+
+	PipelineCacheFile::Header PipelineCacheFile::makeHeader(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data)
+	{
+		Header header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = data.size();
+		header.dataHash = computeHash(data);
+		return header;
+	}
+
+	bool PipelineCacheFile::isCompatible(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data)
+	{
+		//NOTE:Layout of VkPipelineCacheHeaderVersionOne, read field by field since the data has no alignment guarantee.
+		if (data.size() < 16 + VK_UUID_SIZE)
+		{
+			return false;
+		}
+
+		uint32_t headerSize = 0, headerVersion = 0, vendorID = 0, deviceID = 0;
+		std::memcpy(&headerSize, data.data() + 0, sizeof(uint32_t));
+		std::memcpy(&headerVersion, data.data() + 4, sizeof(uint32_t));
+		std::memcpy(&vendorID, data.data() + 8, sizeof(uint32_t));
+		std::memcpy(&deviceID, data.data() + 12, sizeof(uint32_t));
+
+		return
+			headerSize >= 16 + VK_UUID_SIZE &&
+			headerSize <= data.size() &&
+			headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			vendorID == properties.vendorID &&
+			deviceID == properties.deviceID &&
+			std::memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace app
+{
+	//NOTE:VkPipelineCache data saved between runs. The file is ignored when it was written by another
+	//     device or driver, the driver's own header is checked as well as ours.
+	class PipelineCacheFile
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x43504b56; // "VKPC"
+		static constexpr uint32_t VERSION = 1;
+
+		explicit PipelineCacheFile(std::filesystem::path path);
+
+		bool load(const VkPhysicalDeviceProperties& properties, std::vector<uint8_t>& data) const;
+		void save(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data) const;
+
+		const std::filesystem::path& getPath() const { return m_path; }
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+			uint64_t dataHash;
+		};
+
+		static Header makeHeader(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data);
+		static bool isCompatible(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& data);
+
+		std::filesystem::path m_path;
+	};
+}
\ No newline at end of file
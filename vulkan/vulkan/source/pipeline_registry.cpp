@@ -0,0 +1,731 @@
+#include "pipeline_registry.hpp"
+#include "vulkan_app_base.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+namespace app
+{
+	namespace
+	{
+		//NOTE:FNV-1a, fed one member at a time so padding never takes part.
+		class Hasher
+		{
+		public:
+			template<typename T>
+			void add(const T& value)
+			{
+				addBytes(&value, sizeof(T));
+			}
+
+			template<typename T>
+			void add(const std::vector<T>& values)
+			{
+				add(values.size());
+				addBytes(values.data(), sizeof(T) * values.size());
+			}
+
+			void add(const std::string& value)
+			{
+				add(value.size());
+				addBytes(value.data(), value.size());
+			}
+
+			size_t get() const { return static_cast<size_t>(m_hash); }
+
+		private:
+			void addBytes(const void* data, size_t size)
+			{
+				const auto* bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i)
+				{
+					m_hash = (m_hash ^ bytes[i]) * 0x100000001b3ull;
+				}
+			}
+
+			uint64_t m_hash = 0xcbf29ce484222325ull;
+		};
+
+		//NOTE:Vertex input descriptions and specialization map entries have no padding, so byte comparison is exact.
+		template<typename T>
+		bool equalBytes(const std::vector<T>& a, const std::vector<T>& b)
+		{
+			return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+		}
+
+		//NOTE:The create infos of one PipelineState, wired together. Shader stages are the non null modules, vertex first.
+		//     Not copyable, the structs point into each other.
+		class GraphicsPipelineDescription
+		{
+		public:
+			GraphicsPipelineDescription(const PipelineState& state, VkShaderModule vertexModule, VkShaderModule fragmentModule, std::vector<VkVertexInputAttributeDescription> vertexAttributes) :
+				m_state(state),
+				m_vertexAttributes(std::move(vertexAttributes))
+			{
+				m_specializationInfo.mapEntryCount = static_cast<uint32_t>(state.specializationEntries.size());
+				m_specializationInfo.pMapEntries = state.specializationEntries.data();
+				m_specializationInfo.dataSize = state.specializationData.size();
+				m_specializationInfo.pData = state.specializationData.data();
+
+				VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
+				pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				pipelineShaderStageCreateInfo.pName = "main";
+				pipelineShaderStageCreateInfo.pSpecializationInfo = state.specializationEntries.empty() ? nullptr : &m_specializationInfo;
+				if (vertexModule != 0ull)
+				{
+					pipelineShaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+					pipelineShaderStageCreateInfo.module = vertexModule;
+					m_pipelineShaderStageCreateInfos.push_back(pipelineShaderStageCreateInfo);
+				}
+				if (fragmentModule != 0ull)
+				{
+					pipelineShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+					pipelineShaderStageCreateInfo.module = fragmentModule;
+					m_pipelineShaderStageCreateInfos.push_back(pipelineShaderStageCreateInfo);
+				}
+
+				m_pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+				m_pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(state.vertexBindings.size());
+				m_pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = state.vertexBindings.data();
+				m_pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_vertexAttributes.size());
+				m_pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = m_vertexAttributes.data();
+
+				m_pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+				m_pipelineInputAssemblyStateCreateInfo.topology = state.topology;
+
+				//NOTE:Counts only, the rectangles come from vkCmdSetViewport / vkCmdSetScissor.
+				m_pipelineViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+				m_pipelineViewportStateCreateInfo.viewportCount = 1;
+				m_pipelineViewportStateCreateInfo.scissorCount = 1;
+
+				m_pipelineDynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+				m_pipelineDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(DYNAMIC_STATES.size());
+				m_pipelineDynamicStateCreateInfo.pDynamicStates = DYNAMIC_STATES.data();
+
+				m_pipelineRasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+				m_pipelineRasterizationStateCreateInfo.polygonMode = state.polygonMode;
+				m_pipelineRasterizationStateCreateInfo.cullMode = state.cullMode;
+				m_pipelineRasterizationStateCreateInfo.frontFace = state.frontFace;
+				m_pipelineRasterizationStateCreateInfo.lineWidth = 1.0f;
+
+				m_pipelineMultisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+				m_pipelineMultisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+				m_pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+				m_pipelineDepthStencilStateCreateInfo.depthTestEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+				m_pipelineDepthStencilStateCreateInfo.depthCompareOp = state.depthCompareOp;
+				m_pipelineDepthStencilStateCreateInfo.depthWriteEnable = state.depthWrite ? VK_TRUE : VK_FALSE;
+				m_pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
+
+				m_pipelineColorBlendAttachmentState.colorWriteMask =
+					VK_COLOR_COMPONENT_R_BIT |
+					VK_COLOR_COMPONENT_G_BIT |
+					VK_COLOR_COMPONENT_B_BIT |
+					VK_COLOR_COMPONENT_A_BIT;
+				switch (state.blendMode)
+				{
+				case BlendMode::Alpha:
+					m_pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
+					m_pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+					m_pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					m_pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+					m_pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+					m_pipelineColorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+					m_pipelineColorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+					break;
+				case BlendMode::None:
+					m_pipelineColorBlendAttachmentState.colorWriteMask = 0;
+					break;
+				default:
+					break;
+				}
+				m_pipelineColorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+				m_pipelineColorBlendStateCreateInfo.attachmentCount = 1;
+				m_pipelineColorBlendStateCreateInfo.pAttachments = &m_pipelineColorBlendAttachmentState;
+			}
+
+			GraphicsPipelineDescription(const GraphicsPipelineDescription&) = delete;
+			GraphicsPipelineDescription& operator=(const GraphicsPipelineDescription&) = delete;
+
+			VkGraphicsPipelineCreateInfo getCreateInfo() const
+			{
+				VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
+				graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+				graphicsPipelineCreateInfo.stageCount = static_cast<uint32_t>(m_pipelineShaderStageCreateInfos.size());
+				graphicsPipelineCreateInfo.pStages = m_pipelineShaderStageCreateInfos.data();
+				graphicsPipelineCreateInfo.pInputAssemblyState = &m_pipelineInputAssemblyStateCreateInfo;
+				graphicsPipelineCreateInfo.pVertexInputState = &m_pipelineVertexInputStateCreateInfo;
+				graphicsPipelineCreateInfo.pRasterizationState = &m_pipelineRasterizationStateCreateInfo;
+				graphicsPipelineCreateInfo.pDepthStencilState = &m_pipelineDepthStencilStateCreateInfo;
+				graphicsPipelineCreateInfo.pMultisampleState = &m_pipelineMultisampleStateCreateInfo;
+				graphicsPipelineCreateInfo.pViewportState = &m_pipelineViewportStateCreateInfo;
+				graphicsPipelineCreateInfo.pColorBlendState = &m_pipelineColorBlendStateCreateInfo;
+				graphicsPipelineCreateInfo.pDynamicState = &m_pipelineDynamicStateCreateInfo;
+				graphicsPipelineCreateInfo.renderPass = m_state.renderPass;
+				graphicsPipelineCreateInfo.subpass = m_state.subpass;
+				graphicsPipelineCreateInfo.layout = m_state.layout;
+				return graphicsPipelineCreateInfo;
+			}
+
+			//NOTE:Only the state that belongs to part, chained to libraryCreateInfo.
+			VkGraphicsPipelineCreateInfo getLibraryCreateInfo(VkGraphicsPipelineLibraryFlagBitsEXT part, VkGraphicsPipelineLibraryCreateInfoEXT& libraryCreateInfo) const
+			{
+				libraryCreateInfo = {};
+				libraryCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+				libraryCreateInfo.flags = part;
+
+				const auto isVertexInput = part == VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+				const auto isPreRasterization = part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+				const auto isFragmentShader = part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+				const auto isFragmentOutput = part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+				auto graphicsPipelineCreateInfo = getCreateInfo();
+				graphicsPipelineCreateInfo.pNext = &libraryCreateInfo;
+				//NOTE:Retained so the optimized link can optimize across the libraries.
+				graphicsPipelineCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+				if (!isPreRasterization && !isFragmentShader)
+				{
+					graphicsPipelineCreateInfo.stageCount = 0;
+					graphicsPipelineCreateInfo.pStages = nullptr;
+					graphicsPipelineCreateInfo.layout = 0ull;
+				}
+				if (!isVertexInput)
+				{
+					graphicsPipelineCreateInfo.pVertexInputState = nullptr;
+					graphicsPipelineCreateInfo.pInputAssemblyState = nullptr;
+				}
+				else
+				{
+					graphicsPipelineCreateInfo.renderPass = 0ull;
+					graphicsPipelineCreateInfo.subpass = 0;
+				}
+				if (!isPreRasterization)
+				{
+					graphicsPipelineCreateInfo.pViewportState = nullptr;
+					graphicsPipelineCreateInfo.pRasterizationState = nullptr;
+					graphicsPipelineCreateInfo.pDynamicState = nullptr;
+				}
+				if (!isFragmentShader)
+				{
+					graphicsPipelineCreateInfo.pDepthStencilState = nullptr;
+				}
+				if (!isFragmentShader && !isFragmentOutput)
+				{
+					graphicsPipelineCreateInfo.pMultisampleState = nullptr;
+				}
+				if (!isFragmentOutput)
+				{
+					graphicsPipelineCreateInfo.pColorBlendState = nullptr;
+				}
+				return graphicsPipelineCreateInfo;
+			}
+
+		private:
+			static constexpr std::array<VkDynamicState, 2> DYNAMIC_STATES
+			{
+				VK_DYNAMIC_STATE_VIEWPORT,
+				VK_DYNAMIC_STATE_SCISSOR,
+			};
+
+			const PipelineState& m_state;
+			std::vector<VkVertexInputAttributeDescription> m_vertexAttributes;
+			VkSpecializationInfo m_specializationInfo{};
+			std::vector<VkPipelineShaderStageCreateInfo> m_pipelineShaderStageCreateInfos;
+			VkPipelineVertexInputStateCreateInfo m_pipelineVertexInputStateCreateInfo{};
+			VkPipelineInputAssemblyStateCreateInfo m_pipelineInputAssemblyStateCreateInfo{};
+			VkPipelineViewportStateCreateInfo m_pipelineViewportStateCreateInfo{};
+			VkPipelineDynamicStateCreateInfo m_pipelineDynamicStateCreateInfo{};
+			VkPipelineRasterizationStateCreateInfo m_pipelineRasterizationStateCreateInfo{};
+			VkPipelineMultisampleStateCreateInfo m_pipelineMultisampleStateCreateInfo{};
+			VkPipelineDepthStencilStateCreateInfo m_pipelineDepthStencilStateCreateInfo{};
+			VkPipelineColorBlendAttachmentState m_pipelineColorBlendAttachmentState{};
+			VkPipelineColorBlendStateCreateInfo m_pipelineColorBlendStateCreateInfo{};
+		};
+	}
+
+	size_t PipelineState::hash() const
+	{
+		Hasher hasher;
+		hasher.add(vertexShader);
+		hasher.add(fragmentShader);
+		hasher.add(vertexBindings);
+		hasher.add(vertexAttributes);
+		hasher.add(topology);
+		hasher.add(polygonMode);
+		hasher.add(cullMode);
+		hasher.add(frontFace);
+		hasher.add(depthTest);
+		hasher.add(depthWrite);
+		hasher.add(depthCompareOp);
+		hasher.add(blendMode);
+		hasher.add(layout);
+		hasher.add(renderPass);
+		hasher.add(subpass);
+		hasher.add(specializationEntries);
+		hasher.add(specializationData);
+		return hasher.get();
+	}
+
+	bool PipelineState::operator==(const PipelineState& other) const
+	{
+		return
+			vertexShader == other.vertexShader &&
+			fragmentShader == other.fragmentShader &&
+			equalBytes(vertexBindings, other.vertexBindings) &&
+			equalBytes(vertexAttributes, other.vertexAttributes) &&
+			topology == other.topology &&
+			polygonMode == other.polygonMode &&
+			cullMode == other.cullMode &&
+			frontFace == other.frontFace &&
+			depthTest == other.depthTest &&
+			depthWrite == other.depthWrite &&
+			depthCompareOp == other.depthCompareOp &&
+			blendMode == other.blendMode &&
+			layout == other.layout &&
+			renderPass == other.renderPass &&
+			subpass == other.subpass &&
+			equalBytes(specializationEntries, other.specializationEntries) &&
+			specializationData == other.specializationData;
+	}
+
+	void PipelineRegistry::initialize(VkDevice device, VkPipelineCache pipelineCache, ShaderModuleCache& shaderModuleCache, bool useLibraries)
+	{
+		m_device = device;
+		m_pipelineCache = pipelineCache;
+		m_shaderModuleCache = &shaderModuleCache;
+		m_useLibraries = useLibraries;
+		if (m_useLibraries)
+		{
+			m_optimizeThreadPool = std::make_unique<ThreadPool>(1);
+		}
+
+		std::stringstream ss;
+		ss << "pipeline registry: " << (m_useLibraries ? "graphics pipeline libraries" : "monolithic pipelines") << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+	}
+
+	void PipelineRegistry::destroy()
+	{
+		//NOTE:Joins the optimized link in progress, it may still be reading the libraries.
+		m_optimizeThreadPool.reset();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& [state, pipeline] : m_pipelines)
+		{
+			vkDestroyPipeline(m_device, pipeline.get(), nullptr);
+		}
+		m_pipelines.clear();
+
+		for (const auto& optimizedPipeline : m_optimizedPipelines)
+		{
+			vkDestroyPipeline(m_device, optimizedPipeline.optimized, nullptr);
+		}
+		m_optimizedPipelines.clear();
+
+		for (auto& libraries : m_libraries)
+		{
+			for (const auto& [key, library] : libraries)
+			{
+				vkDestroyPipeline(m_device, library, nullptr);
+			}
+			libraries.clear();
+		}
+		for (auto library : m_retiredLibraries)
+		{
+			vkDestroyPipeline(m_device, library, nullptr);
+		}
+		m_retiredLibraries.clear();
+	}
+
+	VkPipeline PipelineRegistry::getPipeline(const PipelineState& state)
+	{
+		std::promise<VkPipeline> promise;
+		std::shared_future<VkPipeline> existing;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_pipelines.find(state);
+			if (found != m_pipelines.end())
+			{
+				existing = found->second;
+			}
+			else
+			{
+				m_pipelines.emplace(state, promise.get_future().share());
+			}
+		}
+
+		//NOTE:Another thread may still be compiling it, wait outside the lock.
+		if (existing.valid())
+		{
+			return existing.get();
+		}
+
+		auto pipeline = buildPipeline(state);
+		promise.set_value(pipeline);
+		return pipeline;
+	}
+
+	std::shared_future<VkPipeline> PipelineRegistry::requestPipeline(const PipelineState& state, ThreadPool& threadPool)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_pipelines.find(state);
+		if (found != m_pipelines.end())
+		{
+			return found->second;
+		}
+
+		auto pipeline = threadPool.enqueue([this, state]() { return buildPipeline(state); }).share();
+		m_pipelines.emplace(state, pipeline);
+		return pipeline;
+	}
+
+	size_t PipelineRegistry::getPipelineCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pipelines.size();
+	}
+
+	std::vector<std::string> PipelineRegistry::getShaderFileNames() const
+	{
+		std::set<std::string> fileNames;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const auto& [state, pipeline] : m_pipelines)
+			{
+				fileNames.insert(state.vertexShader);
+				if (!state.fragmentShader.empty())
+				{
+					fileNames.insert(state.fragmentShader);
+				}
+			}
+		}
+		return { fileNames.begin(), fileNames.end() };
+	}
+
+	std::unordered_map<VkPipeline, VkPipeline> PipelineRegistry::rebuildPipelines(const std::string& fileName, const std::function<void(VkPipeline)>& retire)
+	{
+		std::vector<std::pair<PipelineState, std::shared_future<VkPipeline>>> affected;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const auto& [state, pipeline] : m_pipelines)
+			{
+				if (state.vertexShader == fileName || state.fragmentShader == fileName)
+				{
+					affected.emplace_back(state, pipeline);
+				}
+			}
+
+			//NOTE:Libraries built from the old module must not be linked again.
+			for (auto& libraries : m_libraries)
+			{
+				for (auto it = libraries.begin(); it != libraries.end();)
+				{
+					if (it->first.vertexShader == fileName || it->first.fragmentShader == fileName)
+					{
+						m_retiredLibraries.push_back(it->second);
+						it = libraries.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+		}
+
+		//NOTE:Compiled outside the lock, requests for other states carry on meanwhile.
+		std::unordered_map<VkPipeline, VkPipeline> replaced;
+		for (auto& [state, oldPipeline] : affected)
+		{
+			const auto pipeline = oldPipeline.get();
+			const auto newPipeline = buildPipeline(state);
+			if (newPipeline == 0ull)
+			{
+				continue;
+			}
+
+			std::promise<VkPipeline> promise;
+			promise.set_value(newPipeline);
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_pipelines[state] = promise.get_future().share();
+			}
+			replaced.emplace(pipeline, newPipeline);
+			retire(pipeline);
+		}
+		return replaced;
+	}
+
+	std::unordered_map<VkPipeline, VkPipeline> PipelineRegistry::collectOptimizedPipelines(const std::function<void(VkPipeline)>& retire)
+	{
+		std::unordered_map<VkPipeline, VkPipeline> replaced;
+		if (!m_useLibraries)
+		{
+			return replaced;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<OptimizedPipeline> pending;
+		for (auto& optimizedPipeline : m_optimizedPipelines)
+		{
+			auto found = m_pipelines.find(optimizedPipeline.state);
+			//NOTE:The fast link may have finished before its future was set, look again next frame.
+			if (found != m_pipelines.end() && found->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				pending.push_back(std::move(optimizedPipeline));
+				continue;
+			}
+
+			//NOTE:A hot reload may have replaced the fast linked pipeline meanwhile, then this one is stale.
+			if (found == m_pipelines.end() || found->second.get() != optimizedPipeline.fastLinked)
+			{
+				vkDestroyPipeline(m_device, optimizedPipeline.optimized, nullptr);
+				continue;
+			}
+
+			std::promise<VkPipeline> promise;
+			promise.set_value(optimizedPipeline.optimized);
+			found->second = promise.get_future().share();
+			replaced.emplace(optimizedPipeline.fastLinked, optimizedPipeline.optimized);
+			retire(optimizedPipeline.fastLinked);
+		}
+		m_optimizedPipelines.swap(pending);
+		return replaced;
+	}
+
+	VkPipeline PipelineRegistry::buildPipeline(const PipelineState& state)
+	{
+		if (m_useLibraries)
+		{
+			const auto pipeline = linkPipeline(state, false);
+			if (pipeline != 0ull)
+			{
+				m_optimizeThreadPool->enqueue([this, state, pipeline]()
+					{
+						const auto optimized = linkPipeline(state, true);
+						if (optimized == 0ull)
+						{
+							return;
+						}
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_optimizedPipelines.push_back({ state, pipeline, optimized });
+					});
+				return pipeline;
+			}
+		}
+		return createPipeline(state);
+	}
+
+	VkPipeline PipelineRegistry::createPipeline(const PipelineState& state) const
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		VkShaderModule vertexModule = 0ull, fragmentModule = 0ull;
+		if (state.vertexShader.empty() || !getShaderModule(state.vertexShader, vertexModule) || !getShaderModule(state.fragmentShader, fragmentModule))
+		{
+			return 0ull;
+		}
+
+		GraphicsPipelineDescription description(state, vertexModule, fragmentModule, getVertexAttributes(state));
+		const auto graphicsPipelineCreateInfo = description.getCreateInfo();
+
+		VkPipeline pipeline = 0ull;
+		vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &graphicsPipelineCreateInfo, nullptr, &pipeline);
+
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::stringstream ss;
+		ss << "pipeline registry: compiled " << state.vertexShader << " / " << (state.fragmentShader.empty() ? "(depth only)" : state.fragmentShader) << " in " << elapsed << " ms" << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+		return pipeline;
+	}
+
+	VkPipeline PipelineRegistry::linkPipeline(const PipelineState& state, bool optimize)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		std::array<VkPipeline, LIBRARY_PARTS.size()> libraries{};
+		for (size_t part = 0; part < LIBRARY_PARTS.size(); ++part)
+		{
+			libraries[part] = getLibrary(state, part);
+			if (libraries[part] == 0ull)
+			{
+				return 0ull;
+			}
+		}
+
+		VkPipelineLibraryCreateInfoKHR pipelineLibraryCreateInfo{};
+		pipelineLibraryCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		pipelineLibraryCreateInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+		pipelineLibraryCreateInfo.pLibraries = libraries.data();
+
+		//NOTE:Without LINK_TIME_OPTIMIZATION the driver only stitches the libraries together, which is fast enough to do mid frame.
+		VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
+		graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		graphicsPipelineCreateInfo.pNext = &pipelineLibraryCreateInfo;
+		graphicsPipelineCreateInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+		graphicsPipelineCreateInfo.layout = state.layout;
+
+		VkPipeline pipeline = 0ull;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &graphicsPipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+		{
+			return 0ull;
+		}
+
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::stringstream ss;
+		ss << "pipeline registry: " << (optimize ? "optimized " : "linked ") << state.vertexShader << " / " << (state.fragmentShader.empty() ? "(depth only)" : state.fragmentShader) << " in " << elapsed << " ms" << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+		return pipeline;
+	}
+
+	VkPipeline PipelineRegistry::getLibrary(const PipelineState& state, size_t part)
+	{
+		auto key = getLibraryKey(state, part);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_libraries[part].find(key);
+			if (found != m_libraries[part].end())
+			{
+				return found->second;
+			}
+		}
+
+		//NOTE:Built outside the lock. Two threads may build the same library, the later one is dropped.
+		const auto library = createLibrary(key, part);
+		if (library == 0ull)
+		{
+			return 0ull;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto [found, inserted] = m_libraries[part].emplace(std::move(key), library);
+		if (!inserted)
+		{
+			vkDestroyPipeline(m_device, library, nullptr);
+		}
+		return found->second;
+	}
+
+	VkPipeline PipelineRegistry::createLibrary(const PipelineState& key, size_t part) const
+	{
+		VkShaderModule vertexModule = 0ull, fragmentModule = 0ull;
+		if (!getShaderModule(key.vertexShader, vertexModule) || !getShaderModule(key.fragmentShader, fragmentModule))
+		{
+			return 0ull;
+		}
+
+		const auto isVertexInput = LIBRARY_PARTS[part] == VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+		GraphicsPipelineDescription description(key, vertexModule, fragmentModule, isVertexInput ? getVertexAttributes(key) : std::vector<VkVertexInputAttributeDescription>{});
+		VkGraphicsPipelineLibraryCreateInfoEXT graphicsPipelineLibraryCreateInfo{};
+		const auto graphicsPipelineCreateInfo = description.getLibraryCreateInfo(LIBRARY_PARTS[part], graphicsPipelineLibraryCreateInfo);
+
+		VkPipeline library = 0ull;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &graphicsPipelineCreateInfo, nullptr, &library) != VK_SUCCESS)
+		{
+			return 0ull;
+		}
+		return library;
+	}
+
+	PipelineState PipelineRegistry::getLibraryKey(const PipelineState& state, size_t part) const
+	{
+		//NOTE:Only the constants the stage declares, so e.g. the fragment only alpha mode does not split the vertex library.
+		auto copySpecialization = [this, &state](const std::string& fileName, PipelineState& key)
+		{
+			ShaderReflection reflection;
+			if (!m_shaderModuleCache->getReflection(fileName, reflection))
+			{
+				key.specializationEntries = state.specializationEntries;
+				key.specializationData = state.specializationData;
+				return;
+			}
+			for (const auto& entry : state.specializationEntries)
+			{
+				if (!std::binary_search(reflection.specializationConstantIds.begin(), reflection.specializationConstantIds.end(), entry.constantID))
+				{
+					continue;
+				}
+				const VkSpecializationMapEntry keyEntry{ entry.constantID, static_cast<uint32_t>(key.specializationData.size()), entry.size };
+				key.specializationEntries.push_back(keyEntry);
+				key.specializationData.insert(key.specializationData.end(), state.specializationData.begin() + entry.offset, state.specializationData.begin() + entry.offset + entry.size);
+			}
+		};
+
+		PipelineState key{};
+		switch (LIBRARY_PARTS[part])
+		{
+		case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+			//NOTE:The vertex shader decides which attributes are stripped.
+			key.vertexShader = state.vertexShader;
+			key.vertexBindings = state.vertexBindings;
+			key.vertexAttributes = state.vertexAttributes;
+			key.topology = state.topology;
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+			key.vertexShader = state.vertexShader;
+			key.polygonMode = state.polygonMode;
+			key.cullMode = state.cullMode;
+			key.frontFace = state.frontFace;
+			key.layout = state.layout;
+			key.renderPass = state.renderPass;
+			key.subpass = state.subpass;
+			copySpecialization(state.vertexShader, key);
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+			key.fragmentShader = state.fragmentShader;
+			key.depthTest = state.depthTest;
+			key.depthWrite = state.depthWrite;
+			key.depthCompareOp = state.depthCompareOp;
+			key.layout = state.layout;
+			key.renderPass = state.renderPass;
+			key.subpass = state.subpass;
+			if (!state.fragmentShader.empty())
+			{
+				copySpecialization(state.fragmentShader, key);
+			}
+			break;
+		case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+			key.blendMode = state.blendMode;
+			key.renderPass = state.renderPass;
+			key.subpass = state.subpass;
+			break;
+		default:
+			break;
+		}
+		return key;
+	}
+
+	bool PipelineRegistry::getShaderModule(const std::string& fileName, VkShaderModule& shaderModule) const
+	{
+		shaderModule = 0ull;
+		if (fileName.empty())
+		{
+			return true;
+		}
+		shaderModule = m_shaderModuleCache->get(fileName);
+		return shaderModule != 0ull;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> PipelineRegistry::getVertexAttributes(const PipelineState& state) const
+	{
+		//NOTE:The CPU vertex format is checked against what the vertex shader declares, and attributes it
+		//     never reads are left out so the input assembler does not fetch them.
+		ShaderReflection vertexReflection;
+		if (!m_shaderModuleCache->getReflection(state.vertexShader, vertexReflection))
+		{
+			return state.vertexAttributes;
+		}
+
+		if (!SpirvReflection::validateVertexInputs(vertexReflection, state.vertexBindings, state.vertexAttributes, state.vertexShader))
+		{
+#ifdef _DEBUG
+			DebugBreak();
+#endif // _DEBUG
+		}
+		return SpirvReflection::stripUnusedAttributes(vertexReflection, state.vertexAttributes);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "shader_module_cache.hpp"
+#include "thread_pool.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace app
+{
+	enum class BlendMode
+	{
+		//NOTE:Writes the fragment color as is.
+		Opaque,
+		//NOTE:Straight alpha, SRC_ALPHA / ONE_MINUS_SRC_ALPHA.
+		Alpha,
+		//NOTE:Color writes masked off, for depth only passes.
+		None,
+	};
+
+	//NOTE:Everything that tells two graphics pipelines apart. Viewport and scissor are dynamic state set by
+	//     VulkanAppBase::render, so the swapchain size is not part of it. An empty fragmentShader builds a depth only pipeline.
+	struct PipelineState
+	{
+		std::string vertexShader;
+		std::string fragmentShader;
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+		VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		bool depthTest = true;
+		bool depthWrite = true;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		BlendMode blendMode = BlendMode::Opaque;
+		VkPipelineLayout layout = 0ull;
+		VkRenderPass renderPass = 0ull;
+		uint32_t subpass = 0;
+		//NOTE:Applied to every stage, constant IDs a stage does not declare are ignored.
+		//     Fill through setSpecializationConstant in a fixed order so equal values compare equal.
+		std::vector<VkSpecializationMapEntry> specializationEntries;
+		std::vector<uint8_t> specializationData;
+
+		//NOTE:bool constants take a VkBool32.
+		template<typename T>
+		void setSpecializationConstant(uint32_t constantId, const T& value);
+
+		size_t hash() const;
+		bool operator==(const PipelineState& other) const;
+		bool operator!=(const PipelineState& other) const { return !(*this == other); }
+	};
+
+	template<typename T>
+	void PipelineState::setSpecializationConstant(uint32_t constantId, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "specialization constants are plain scalars");
+
+		for (const auto& entry : specializationEntries)
+		{
+			if (entry.constantID == constantId && entry.size == sizeof(T))
+			{
+				std::memcpy(specializationData.data() + entry.offset, &value, sizeof(T));
+				return;
+			}
+		}
+
+		const VkSpecializationMapEntry entry{ constantId, static_cast<uint32_t>(specializationData.size()), sizeof(T) };
+		specializationEntries.push_back(entry);
+		specializationData.resize(specializationData.size() + sizeof(T));
+		std::memcpy(specializationData.data() + entry.offset, &value, sizeof(T));
+	}
+
+	struct PipelineStateHash
+	{
+		size_t operator()(const PipelineState& state) const { return state.hash(); }
+	};
+
+	//NOTE:Returns the pipeline already built for an identical state, or builds it on first request.
+	//     Owns every pipeline it hands out, apps keep only the handles.
+	//     Safe to call from any thread. The pipeline cache must not be created EXTERNALLY_SYNCHRONIZED,
+	//     compiles on different threads share it.
+	//     With useLibraries (VK_EXT_graphics_pipeline_library) a pipeline is linked from vertex input, pre-rasterization,
+	//     fragment shader and fragment output libraries, each built once for the part of the state it covers.
+	//     The first link is a fast one, an optimized link is made in the background and handed out through
+	//     collectOptimizedPipelines. A state whose libraries fail to build or link is compiled as a whole.
+	class PipelineRegistry
+	{
+	public:
+		void initialize(VkDevice device, VkPipelineCache pipelineCache, ShaderModuleCache& shaderModuleCache, bool useLibraries = false);
+		//NOTE:Waits for compiles still in flight, so their pool has to outlive them. Optimized links not yet started are dropped.
+		void destroy();
+
+		//NOTE:Compiles on the calling thread.
+		VkPipeline getPipeline(const PipelineState& state);
+		//NOTE:Compiles on threadPool. Request every independent pipeline first, then wait,
+		//     so the driver compiles them side by side.
+		std::shared_future<VkPipeline> requestPipeline(const PipelineState& state, ThreadPool& threadPool);
+
+		size_t getPipelineCount() const;
+		//NOTE:Every shader file some registered pipeline is built from.
+		std::vector<std::string> getShaderFileNames() const;
+
+		//NOTE:Rebuilds only the pipelines built from fileName, with the module the shader module cache now maps it to.
+		//     Returns old -> new handles. The old pipelines go to retire, which has to keep them alive until
+		//     no frame in flight uses them. A pipeline that fails to build keeps its old handle.
+		std::unordered_map<VkPipeline, VkPipeline> rebuildPipelines(const std::string& fileName, const std::function<void(VkPipeline)>& retire);
+
+		//NOTE:Swaps in the optimized links finished since the last call. Returns old -> new handles,
+		//     the fast linked pipelines go to retire as in rebuildPipelines. Does nothing without libraries.
+		std::unordered_map<VkPipeline, VkPipeline> collectOptimizedPipelines(const std::function<void(VkPipeline)>& retire);
+
+		bool isUsingLibraries() const { return m_useLibraries; }
+
+	private:
+		static constexpr std::array<VkGraphicsPipelineLibraryFlagBitsEXT, 4> LIBRARY_PARTS
+		{
+			VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+			VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+			VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+			VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+		};
+
+		struct OptimizedPipeline
+		{
+			PipelineState state;
+			VkPipeline fastLinked;
+			VkPipeline optimized;
+		};
+
+		//NOTE:Links from libraries when enabled, otherwise compiles the whole pipeline.
+		VkPipeline buildPipeline(const PipelineState& state);
+		VkPipeline createPipeline(const PipelineState& state) const;
+		VkPipeline linkPipeline(const PipelineState& state, bool optimize);
+		VkPipeline getLibrary(const PipelineState& state, size_t part);
+		VkPipeline createLibrary(const PipelineState& key, size_t part) const;
+		//NOTE:state with everything the library part does not use reset, identical keys share one library.
+		PipelineState getLibraryKey(const PipelineState& state, size_t part) const;
+
+		bool getShaderModule(const std::string& fileName, VkShaderModule& shaderModule) const;
+		//NOTE:Validated against the vertex shader, with the attributes it never reads left out.
+		std::vector<VkVertexInputAttributeDescription> getVertexAttributes(const PipelineState& state) const;
+
+		VkDevice m_device = VK_NULL_HANDLE;
+		VkPipelineCache m_pipelineCache = 0ull;
+		ShaderModuleCache* m_shaderModuleCache = nullptr;
+		mutable std::mutex m_mutex;
+		std::unordered_map<PipelineState, std::shared_future<VkPipeline>, PipelineStateHash> m_pipelines;
+
+		bool m_useLibraries = false;
+		std::array<std::unordered_map<PipelineState, VkPipeline, PipelineStateHash>, LIBRARY_PARTS.size()> m_libraries;
+		//NOTE:Dropped by rebuildPipelines but kept until destroy, optimized links may still be made from them.
+		std::vector<VkPipeline> m_retiredLibraries;
+		std::vector<OptimizedPipeline> m_optimizedPipelines;
+		//NOTE:A single thread, so optimized links never compete with requestPipeline for the cores.
+		std::unique_ptr<ThreadPool> m_optimizeThreadPool;
+	};
+}
\ No newline at end of file
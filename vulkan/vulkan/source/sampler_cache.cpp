@@ -0,0 +1,62 @@
+#include "sampler_cache.hpp"
+
+#include <algorithm>
+
+namespace app
+{
+	void SamplerCache::initialize(VkPhysicalDevice physicalDevice, VkDevice device)
+	{
+		m_device = device;
+
+		VkPhysicalDeviceFeatures features{};
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		//NOTE:VulkanAppBase enables every supported feature, so support is all that needs checking.
+		m_anisotropySupported = features.samplerAnisotropy == VK_TRUE;
+		m_maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+	}
+
+	void SamplerCache::destroy()
+	{
+		for (auto& [key, sampler] : m_samplers)
+		{
+			vkDestroySampler(m_device, sampler, nullptr);
+		}
+		m_samplers.clear();
+	}
+
+	VkSampler SamplerCache::get(const VkSamplerCreateInfo& createInfo)
+	{
+		auto clamped = createInfo;
+		clamped.anisotropyEnable = createInfo.anisotropyEnable == VK_TRUE && m_anisotropySupported && createInfo.maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+		clamped.maxAnisotropy = clamped.anisotropyEnable == VK_TRUE ? std::min(createInfo.maxAnisotropy, m_maxAnisotropy) : 1.0f;
+
+		const Key key{
+			clamped.magFilter,
+			clamped.minFilter,
+			clamped.mipmapMode,
+			clamped.addressModeU,
+			clamped.addressModeV,
+			clamped.addressModeW,
+			clamped.mipLodBias,
+			clamped.anisotropyEnable,
+			clamped.maxAnisotropy,
+			clamped.minLod,
+			clamped.maxLod,
+			clamped.borderColor,
+		};
+
+		auto found = m_samplers.find(key);
+		if (found != m_samplers.end())
+		{
+			return found->second;
+		}
+
+		VkSampler sampler = 0ull;
+		vkCreateSampler(m_device, &clamped, nullptr, &sampler);
+		m_samplers.emplace(key, sampler);
+		return sampler;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <tuple>
+
+namespace app
+{
+	//NOTE:Hands out one VkSampler per distinct state, so materials with the same glTF sampler share it.
+	//     Anisotropy is clamped to what the device supports before the lookup.
+	class SamplerCache
+	{
+	public:
+		void initialize(VkPhysicalDevice physicalDevice, VkDevice device);
+		void destroy();
+
+		//NOTE:Only the fields below take part in the key, pNext and flags must be empty.
+		VkSampler get(const VkSamplerCreateInfo& createInfo);
+
+		size_t getSamplerCount() const { return m_samplers.size(); }
+
+	private:
+		using Key = std::tuple<VkFilter, VkFilter, VkSamplerMipmapMode, VkSamplerAddressMode, VkSamplerAddressMode, VkSamplerAddressMode, float, VkBool32, float, float, float, VkBorderColor>;
+
+		VkDevice m_device = VK_NULL_HANDLE;
+		bool m_anisotropySupported = false;
+		float m_maxAnisotropy = 1.0f;
+		std::map<Key, VkSampler> m_samplers;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "shader_module_cache.hpp"
+#include "embedded_shaders.hpp"
+#include "vulkan_app_base.hpp"
+
+#include <fstream>
+#include <sstream>
+
+namespace app
+{
+	void ShaderModuleCache::initialize(VkDevice device)
+	{
+		m_device = device;
+	}
+
+	void ShaderModuleCache::destroy()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& module : m_modules)
+		{
+			vkDestroyShaderModule(m_device, module.module, nullptr);
+		}
+		m_modules.clear();
+		m_freeModules.clear();
+		m_modulesByHash.clear();
+		m_modulesByPath.clear();
+	}
+
+	VkShaderModule ShaderModuleCache::get(const std::string& fileName)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto found = m_modulesByPath.find(fileName);
+			if (found != m_modulesByPath.end())
+			{
+				return m_modules[found->second].module;
+			}
+		}
+
+		return load(fileName, false, nullptr);
+	}
+
+	VkShaderModule ShaderModuleCache::reload(const std::string& fileName, VkShaderModule& replacedModule)
+	{
+		replacedModule = 0ull;
+		return load(fileName, true, &replacedModule);
+	}
+
+	VkShaderModule ShaderModuleCache::load(const std::string& fileName, bool reload, VkShaderModule* replacedModule)
+	{
+		//NOTE:Embedded SPIR-V wins, the file is only read for shaders built without it or on reload.
+		//     Read outside the lock so compiles on other threads are not held up by the disk.
+		std::vector<uint32_t> code;
+		const auto* embedded = reload ? nullptr : EmbeddedShaders::find(fileName);
+		if (embedded != nullptr)
+		{
+			code.assign(embedded->code, embedded->code + embedded->wordCount);
+		}
+		else if (!readFile(fileName, code))
+		{
+			OutputDebugStringA(fileName.c_str());
+			OutputDebugStringA(" file not found.\n");
+			//NOTE:A reload may race the compiler writing the file, the next change retries.
+			if (!reload)
+			{
+				DebugBreak();
+			}
+			return 0ull;
+		}
+		if (!isValidSpirv(code))
+		{
+			OutputDebugStringA(fileName.c_str());
+			OutputDebugStringA(" is not SPIR-V.\n");
+			if (!reload)
+			{
+				DebugBreak();
+			}
+			return 0ull;
+		}
+
+		const auto hash = hashCode(code);
+
+		ShaderReflection reflection;
+		const auto reflected = SpirvReflection::reflect(code, reflection);
+		if (!reflected)
+		{
+			OutputDebugStringA(fileName.c_str());
+			OutputDebugStringA(" could not be reflected.\n");
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto previous = m_modulesByPath.find(fileName);
+		const auto previousIndex = previous != m_modulesByPath.end() ? previous->second : m_modules.size();
+		if (!reload && previous != m_modulesByPath.end())
+		{
+			return m_modules[previousIndex].module;
+		}
+
+		auto range = m_modulesByHash.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			const auto& module = m_modules[it->second];
+			if (module.code == code)
+			{
+				m_modulesByPath.insert_or_assign(fileName, it->second);
+				releaseUnmapped(previousIndex, replacedModule);
+				return module.module;
+			}
+		}
+
+		VkShaderModule shaderModule = 0ull;
+		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCreateInfo.pCode = code.data();
+		shaderModuleCreateInfo.codeSize = code.size() * sizeof(uint32_t);
+		vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+
+		std::stringstream ss;
+		ss << "shader module cache: " << (reload ? "reloaded " : "loaded ") << fileName << " (" << shaderModuleCreateInfo.codeSize << " bytes, " << (embedded != nullptr ? "embedded" : "disk") << ")" << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+
+		auto index = m_modules.size();
+		if (m_freeModules.empty())
+		{
+			m_modules.emplace_back();
+		}
+		else
+		{
+			index = m_freeModules.back();
+			m_freeModules.pop_back();
+		}
+		m_modules[index] = { std::move(code), shaderModule, std::move(reflection), reflected };
+		m_modulesByHash.emplace(hash, index);
+		m_modulesByPath.insert_or_assign(fileName, index);
+		releaseUnmapped(previousIndex, replacedModule);
+		return shaderModule;
+	}
+
+	void ShaderModuleCache::releaseUnmapped(size_t index, VkShaderModule* replacedModule)
+	{
+		if (replacedModule == nullptr || index >= m_modules.size())
+		{
+			return;
+		}
+		for (const auto& path : m_modulesByPath)
+		{
+			if (path.second == index)
+			{
+				return;
+			}
+		}
+
+		auto& module = m_modules[index];
+		auto range = m_modulesByHash.equal_range(hashCode(module.code));
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second == index)
+			{
+				m_modulesByHash.erase(it);
+				break;
+			}
+		}
+
+		*replacedModule = module.module;
+		module = Module{};
+		m_freeModules.push_back(index);
+	}
+
+	bool ShaderModuleCache::getReflection(const std::string& fileName, ShaderReflection& reflection)
+	{
+		if (get(fileName) == 0ull)
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const auto& module = m_modules[m_modulesByPath.at(fileName)];
+		if (!module.reflected)
+		{
+			return false;
+		}
+		reflection = module.reflection;
+		return true;
+	}
+
+	size_t ShaderModuleCache::getModuleCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_modules.size() - m_freeModules.size();
+	}
+
+	bool ShaderModuleCache::isValidSpirv(const std::vector<uint32_t>& code)
+	{
+		//NOTE:Magic, version, generator, bound and schema make up the 5 word header.
+		return code.size() >= 5 && code[0] == SPIRV_MAGIC;
+	}
+
+	bool ShaderModuleCache::readFile(const std::string& fileName, std::vector<uint32_t>& code)
+	{
+		std::ifstream infile(fileName, std::ios::binary);
+		if (!infile)
+		{
+			return false;
+		}
+
+		const auto size = static_cast<size_t>(infile.seekg(0, std::ifstream::end).tellg());
+		//NOTE:SPIR-V is a stream of 32 bit words.
+		if (size == 0 || size % sizeof(uint32_t) != 0)
+		{
+			code.clear();
+			return true;
+		}
+
+		code.resize(size / sizeof(uint32_t));
+		infile.seekg(0, std::ifstream::beg).read(reinterpret_cast<char*>(code.data()), size);
+		return static_cast<bool>(infile);
+	}
+
+	uint64_t ShaderModuleCache::hashCode(const std::vector<uint32_t>& code)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (auto word : code)
+		{
+			hash = (hash ^ word) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "spirv_reflection.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace app
+{
+	//NOTE:Reads each SPIR-V file once and keeps its VkShaderModule until destroy(), so pipelines
+	//     built later from the same file skip the disk and the module creation.
+	//     Shaders embedded in the executable are taken from there, see EmbeddedShaders.
+	//     Files with identical contents share one module. Safe to call from any thread.
+	//     Each module is reflected once when it is loaded, see SpirvReflection.
+	class ShaderModuleCache
+	{
+	public:
+		static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+		void initialize(VkDevice device);
+		void destroy();
+
+		//NOTE:Returns 0ull when the file is missing or is not SPIR-V.
+		VkShaderModule get(const std::string& fileName);
+		//NOTE:Reads the file from disk again, even when it is embedded, and maps fileName to the result from then on.
+		//     When no other file shares the previous module it is dropped from the cache and handed back in
+		//     replacedModule (0ull otherwise). The caller destroys it once nothing is built from it anymore.
+		//     Returns 0ull and keeps the previous mapping when the file cannot be read.
+		VkShaderModule reload(const std::string& fileName, VkShaderModule& replacedModule);
+
+		//NOTE:Loads the file like get() does. Returns false when it cannot be loaded or reflected.
+		bool getReflection(const std::string& fileName, ShaderReflection& reflection);
+
+		size_t getModuleCount() const;
+
+		static bool isValidSpirv(const std::vector<uint32_t>& code);
+
+	private:
+		struct Module
+		{
+			std::vector<uint32_t> code;
+			VkShaderModule module;
+			ShaderReflection reflection;
+			bool reflected;
+		};
+
+		VkShaderModule load(const std::string& fileName, bool reload, VkShaderModule* replacedModule);
+		//NOTE:Drops the module at index when no file maps to it anymore and hands it to replacedModule. Expects m_mutex held.
+		void releaseUnmapped(size_t index, VkShaderModule* replacedModule);
+
+		static bool readFile(const std::string& fileName, std::vector<uint32_t>& code);
+		static uint64_t hashCode(const std::vector<uint32_t>& code);
+
+		VkDevice m_device = VK_NULL_HANDLE;
+		mutable std::mutex m_mutex;
+		//NOTE:Slots of modules dropped by reload are reused, indices of the others stay put.
+		std::vector<Module> m_modules;
+		std::vector<size_t> m_freeModules;
+		std::unordered_multimap<uint64_t, size_t> m_modulesByHash;
+		std::unordered_map<std::string, size_t> m_modulesByPath;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,708 @@
+#include "spirv_reflection.hpp"
+#include "vulkan_app_base.hpp"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+namespace app
+{
+	namespace
+	{
+		constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+		constexpr size_t SPIRV_HEADER_WORDS = 5;
+
+		enum Op : uint32_t
+		{
+			OpEntryPoint = 15,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+		};
+
+		enum Decoration : uint32_t
+		{
+			DecorationSpecId = 1,
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+		};
+
+		enum StorageClass : uint32_t
+		{
+			StorageClassUniformConstant = 0,
+			StorageClassInput = 1,
+			StorageClassUniform = 2,
+			StorageClassPushConstant = 9,
+			StorageClassStorageBuffer = 12,
+		};
+
+		enum Dim : uint32_t
+		{
+			DimBuffer = 5,
+			DimSubpassData = 6,
+		};
+
+		//NOTE:Operands of a type declaration, opcode first.
+		struct Type
+		{
+			uint32_t opcode = 0;
+			std::vector<uint32_t> operands;
+		};
+
+		struct Variable
+		{
+			uint32_t pointerType;
+			uint32_t storageClass;
+		};
+
+		struct Decorations
+		{
+			std::unordered_map<uint32_t, uint32_t> values;
+			bool has(uint32_t decoration) const { return values.find(decoration) != values.end(); }
+			uint32_t get(uint32_t decoration, uint32_t fallback = 0) const
+			{
+				auto found = values.find(decoration);
+				return found != values.end() ? found->second : fallback;
+			}
+		};
+
+		class Module
+		{
+		public:
+			bool parse(const std::vector<uint32_t>& code)
+			{
+				if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+				{
+					return false;
+				}
+
+				for (size_t i = SPIRV_HEADER_WORDS; i < code.size();)
+				{
+					const auto wordCount = code[i] >> 16;
+					const auto opcode = code[i] & 0xffff;
+					if (wordCount == 0 || i + wordCount > code.size())
+					{
+						return false;
+					}
+					const auto* operands = &code[i + 1];
+					const auto operandCount = wordCount - 1;
+
+					switch (opcode)
+					{
+					case OpEntryPoint:
+						//NOTE:Only the first entry point is reflected, every shader here has one called main.
+						if (!m_hasEntryPoint)
+						{
+							m_executionModel = operands[0];
+							m_hasEntryPoint = true;
+						}
+						break;
+					case OpTypeInt:
+					case OpTypeFloat:
+					case OpTypeVector:
+					case OpTypeMatrix:
+					case OpTypeImage:
+					case OpTypeSampler:
+					case OpTypeSampledImage:
+					case OpTypeArray:
+					case OpTypeRuntimeArray:
+					case OpTypeStruct:
+					case OpTypePointer:
+					{
+						auto& type = m_types[operands[0]];
+						type.opcode = opcode;
+						type.operands.assign(operands + 1, operands + operandCount);
+						break;
+					}
+					case OpConstant:
+						//NOTE:Array lengths are 32 bit integer constants, wider ones are never used as a length.
+						if (operandCount >= 3)
+						{
+							m_constants[operands[1]] = operands[2];
+						}
+						break;
+					case OpVariable:
+						m_variables.emplace_back(operands[1], Variable{ operands[0], operands[2] });
+						break;
+					case OpDecorate:
+						if (operandCount >= 2)
+						{
+							m_decorations[operands[0]].values[operands[1]] = operandCount >= 3 ? operands[2] : 0;
+						}
+						break;
+					case OpMemberDecorate:
+						if (operandCount >= 3)
+						{
+							m_memberDecorations[operands[0]][operands[1]].values[operands[2]] = operandCount >= 4 ? operands[3] : 0;
+						}
+						break;
+					default:
+						break;
+					}
+
+					i += wordCount;
+				}
+				return m_hasEntryPoint;
+			}
+
+			VkShaderStageFlags getStageFlags() const
+			{
+				switch (m_executionModel)
+				{
+				case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+				case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+				case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+				case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+				case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+				case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+				default: return 0;
+				}
+			}
+
+			void reflect(ShaderReflection& reflection) const
+			{
+				reflection.stageFlags = getStageFlags();
+
+				uint32_t pushConstantBegin = UINT32_MAX, pushConstantEnd = 0;
+				for (const auto& [id, variable] : m_variables)
+				{
+					const auto* pointer = findType(variable.pointerType);
+					if (pointer == nullptr || pointer->opcode != OpTypePointer || pointer->operands.size() < 2)
+					{
+						continue;
+					}
+					const auto typeId = pointer->operands[1];
+					const auto decorations = getDecorations(id);
+
+					switch (variable.storageClass)
+					{
+					case StorageClassUniformConstant:
+					case StorageClassUniform:
+					case StorageClassStorageBuffer:
+					{
+						ReflectedBinding binding{};
+						if (decorations.has(DecorationBinding) && getDescriptor(typeId, variable.storageClass, binding))
+						{
+							binding.set = decorations.get(DecorationDescriptorSet);
+							binding.binding = decorations.get(DecorationBinding);
+							binding.stageFlags = reflection.stageFlags;
+							reflection.bindings.push_back(binding);
+						}
+						break;
+					}
+					case StorageClassPushConstant:
+					{
+						const auto* block = findType(typeId);
+						if (block == nullptr || block->opcode != OpTypeStruct)
+						{
+							break;
+						}
+						for (uint32_t member = 0; member < block->operands.size(); ++member)
+						{
+							const auto memberDecorations = getMemberDecorations(typeId, member);
+							const auto offset = memberDecorations.get(DecorationOffset);
+							pushConstantBegin = std::min(pushConstantBegin, offset);
+							pushConstantEnd = std::max(pushConstantEnd, offset + getSize(block->operands[member], memberDecorations));
+						}
+						break;
+					}
+					case StorageClassInput:
+						if (reflection.stageFlags == VK_SHADER_STAGE_VERTEX_BIT && decorations.has(DecorationLocation) && !decorations.has(DecorationBuiltIn))
+						{
+							addVertexInput(typeId, decorations.get(DecorationLocation), reflection.vertexInputs);
+						}
+						break;
+					default:
+						break;
+					}
+				}
+
+				for (const auto& [id, decorations] : m_decorations)
+				{
+					if (decorations.has(DecorationSpecId))
+					{
+						reflection.specializationConstantIds.push_back(decorations.get(DecorationSpecId));
+					}
+				}
+
+				if (pushConstantBegin < pushConstantEnd)
+				{
+					reflection.pushConstantRanges.push_back({ reflection.stageFlags, pushConstantBegin, pushConstantEnd - pushConstantBegin });
+				}
+
+				std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& a, const auto& b) { return std::tie(a.set, a.binding) < std::tie(b.set, b.binding); });
+				std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+				std::sort(reflection.specializationConstantIds.begin(), reflection.specializationConstantIds.end());
+			}
+
+		private:
+			const Type* findType(uint32_t id) const
+			{
+				auto found = m_types.find(id);
+				return found != m_types.end() ? &found->second : nullptr;
+			}
+
+			Decorations getDecorations(uint32_t id) const
+			{
+				auto found = m_decorations.find(id);
+				return found != m_decorations.end() ? found->second : Decorations{};
+			}
+
+			Decorations getMemberDecorations(uint32_t id, uint32_t member) const
+			{
+				auto found = m_memberDecorations.find(id);
+				if (found == m_memberDecorations.end())
+				{
+					return {};
+				}
+				auto foundMember = found->second.find(member);
+				return foundMember != found->second.end() ? foundMember->second : Decorations{};
+			}
+
+			bool getDescriptor(uint32_t typeId, uint32_t storageClass, ReflectedBinding& binding) const
+			{
+				binding.descriptorCount = 1;
+				const auto* type = findType(typeId);
+				//NOTE:Arrays of resources, runtime sized ones count as a single descriptor.
+				while (type != nullptr && (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray))
+				{
+					if (type->opcode == OpTypeArray)
+					{
+						auto found = m_constants.find(type->operands[1]);
+						binding.descriptorCount *= found != m_constants.end() ? found->second : 1;
+					}
+					typeId = type->operands[0];
+					type = findType(typeId);
+				}
+				if (type == nullptr)
+				{
+					return false;
+				}
+
+				switch (type->opcode)
+				{
+				case OpTypeSampler:
+					binding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+					return true;
+				case OpTypeSampledImage:
+					binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					return true;
+				case OpTypeImage:
+				{
+					//NOTE:Operands are sampled type, dim, depth, arrayed, ms, sampled, format.
+					const auto dim = type->operands[1];
+					const auto sampled = type->operands[5];
+					if (dim == DimSubpassData)
+					{
+						binding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					}
+					else if (dim == DimBuffer)
+					{
+						binding.descriptorType = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					}
+					else
+					{
+						binding.descriptorType = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					}
+					return true;
+				}
+				case OpTypeStruct:
+					//NOTE:SPIR-V before 1.3 marks storage buffers as BufferBlock in the Uniform storage class.
+					if (storageClass == StorageClassStorageBuffer || getDecorations(typeId).has(DecorationBufferBlock))
+					{
+						binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					}
+					else
+					{
+						binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					}
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			//NOTE:Size in bytes as laid out in a block. memberDecorations carries the MatrixStride of matrix members.
+			uint32_t getSize(uint32_t typeId, const Decorations& memberDecorations) const
+			{
+				const auto* type = findType(typeId);
+				if (type == nullptr)
+				{
+					return 0;
+				}
+
+				switch (type->opcode)
+				{
+				case OpTypeInt:
+				case OpTypeFloat:
+					return type->operands[0] / 8;
+				case OpTypeVector:
+					return type->operands[1] * getSize(type->operands[0], {});
+				case OpTypeMatrix:
+				{
+					const auto columnSize = getSize(type->operands[0], {});
+					return type->operands[1] * memberDecorations.get(DecorationMatrixStride, columnSize);
+				}
+				case OpTypeArray:
+				{
+					auto found = m_constants.find(type->operands[1]);
+					const auto length = found != m_constants.end() ? found->second : 1;
+					const auto stride = getDecorations(typeId).get(DecorationArrayStride, getSize(type->operands[0], memberDecorations));
+					return length * stride;
+				}
+				case OpTypeStruct:
+				{
+					uint32_t size = 0;
+					for (uint32_t member = 0; member < type->operands.size(); ++member)
+					{
+						const auto decorations = getMemberDecorations(typeId, member);
+						size = std::max(size, decorations.get(DecorationOffset) + getSize(type->operands[member], decorations));
+					}
+					return size;
+				}
+				default:
+					return 0;
+				}
+			}
+
+			void addVertexInput(uint32_t typeId, uint32_t location, std::vector<ReflectedVertexInput>& inputs) const
+			{
+				const auto* type = findType(typeId);
+				if (type == nullptr)
+				{
+					return;
+				}
+
+				if (type->opcode == OpTypeMatrix)
+				{
+					for (uint32_t column = 0; column < type->operands[1]; ++column)
+					{
+						addVertexInput(type->operands[0], location + column, inputs);
+					}
+					return;
+				}
+
+				ReflectedVertexInput input{};
+				input.location = location;
+				input.componentCount = 1;
+				if (type->opcode == OpTypeVector)
+				{
+					input.componentCount = type->operands[1];
+					type = findType(type->operands[0]);
+					if (type == nullptr)
+					{
+						return;
+					}
+				}
+
+				if (type->opcode == OpTypeFloat)
+				{
+					input.numericType = ReflectedNumericType::Float;
+				}
+				else if (type->opcode == OpTypeInt)
+				{
+					input.numericType = type->operands[1] != 0 ? ReflectedNumericType::Int : ReflectedNumericType::Uint;
+				}
+				else
+				{
+					return;
+				}
+				inputs.push_back(input);
+			}
+
+			bool m_hasEntryPoint = false;
+			uint32_t m_executionModel = 0;
+			std::unordered_map<uint32_t, Type> m_types;
+			std::unordered_map<uint32_t, uint32_t> m_constants;
+			std::vector<std::pair<uint32_t, Variable>> m_variables;
+			std::unordered_map<uint32_t, Decorations> m_decorations;
+			std::unordered_map<uint32_t, std::unordered_map<uint32_t, Decorations>> m_memberDecorations;
+		};
+
+		struct FormatInfo
+		{
+			ReflectedNumericType numericType;
+			uint32_t componentCount;
+			uint32_t size;
+		};
+
+		//NOTE:The vertex formats this repo uses and their close relatives. Others are not checked.
+		bool getFormatInfo(VkFormat format, FormatInfo& info)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R32_SFLOAT: info = { ReflectedNumericType::Float, 1, 4 }; return true;
+			case VK_FORMAT_R32G32_SFLOAT: info = { ReflectedNumericType::Float, 2, 8 }; return true;
+			case VK_FORMAT_R32G32B32_SFLOAT: info = { ReflectedNumericType::Float, 3, 12 }; return true;
+			case VK_FORMAT_R32G32B32A32_SFLOAT: info = { ReflectedNumericType::Float, 4, 16 }; return true;
+			case VK_FORMAT_R32_UINT: info = { ReflectedNumericType::Uint, 1, 4 }; return true;
+			case VK_FORMAT_R32G32_UINT: info = { ReflectedNumericType::Uint, 2, 8 }; return true;
+			case VK_FORMAT_R32G32B32_UINT: info = { ReflectedNumericType::Uint, 3, 12 }; return true;
+			case VK_FORMAT_R32G32B32A32_UINT: info = { ReflectedNumericType::Uint, 4, 16 }; return true;
+			case VK_FORMAT_R32_SINT: info = { ReflectedNumericType::Int, 1, 4 }; return true;
+			case VK_FORMAT_R32G32_SINT: info = { ReflectedNumericType::Int, 2, 8 }; return true;
+			case VK_FORMAT_R32G32B32_SINT: info = { ReflectedNumericType::Int, 3, 12 }; return true;
+			case VK_FORMAT_R32G32B32A32_SINT: info = { ReflectedNumericType::Int, 4, 16 }; return true;
+			case VK_FORMAT_R16G16_SFLOAT: info = { ReflectedNumericType::Float, 2, 4 }; return true;
+			case VK_FORMAT_R16G16B16A16_SFLOAT: info = { ReflectedNumericType::Float, 4, 8 }; return true;
+			case VK_FORMAT_R16G16_SNORM: info = { ReflectedNumericType::Float, 2, 4 }; return true;
+			case VK_FORMAT_R16G16B16A16_SNORM: info = { ReflectedNumericType::Float, 4, 8 }; return true;
+			case VK_FORMAT_R16G16_UNORM: info = { ReflectedNumericType::Float, 2, 4 }; return true;
+			case VK_FORMAT_R16G16B16A16_UNORM: info = { ReflectedNumericType::Float, 4, 8 }; return true;
+			case VK_FORMAT_R8G8B8A8_UNORM: info = { ReflectedNumericType::Float, 4, 4 }; return true;
+			case VK_FORMAT_R8G8B8A8_SNORM: info = { ReflectedNumericType::Float, 4, 4 }; return true;
+			case VK_FORMAT_R8G8B8A8_UINT: info = { ReflectedNumericType::Uint, 4, 4 }; return true;
+			default: return false;
+			}
+		}
+	}
+
+	bool SpirvReflection::reflect(const std::vector<uint32_t>& code, ShaderReflection& reflection)
+	{
+		Module module;
+		if (!module.parse(code))
+		{
+			return false;
+		}
+
+		reflection = {};
+		module.reflect(reflection);
+		return true;
+	}
+
+	bool SpirvReflection::merge(const std::vector<ShaderReflection>& stages, ShaderReflection& merged)
+	{
+		merged = {};
+		bool result = true;
+
+		std::map<std::pair<uint32_t, uint32_t>, ReflectedBinding> bindings;
+		std::map<VkShaderStageFlags, std::pair<uint32_t, uint32_t>> pushConstants;
+		for (const auto& stage : stages)
+		{
+			merged.stageFlags |= stage.stageFlags;
+
+			for (const auto& binding : stage.bindings)
+			{
+				auto [found, inserted] = bindings.emplace(std::make_pair(binding.set, binding.binding), binding);
+				if (inserted)
+				{
+					continue;
+				}
+				if (found->second.descriptorType != binding.descriptorType || found->second.descriptorCount != binding.descriptorCount)
+				{
+					std::stringstream ss;
+					ss << "spirv reflection: set " << binding.set << " binding " << binding.binding << " is declared differently across stages." << std::endl;
+					OutputDebugStringA(ss.str().c_str());
+					result = false;
+					continue;
+				}
+				found->second.stageFlags |= binding.stageFlags;
+			}
+
+			//NOTE:Vulkan allows each stage in one range only, so ranges of the same stage are widened to cover both.
+			for (const auto& range : stage.pushConstantRanges)
+			{
+				auto [found, inserted] = pushConstants.emplace(range.stageFlags, std::make_pair(range.offset, range.offset + range.size));
+				if (!inserted)
+				{
+					found->second.first = std::min(found->second.first, range.offset);
+					found->second.second = std::max(found->second.second, range.offset + range.size);
+				}
+			}
+
+			merged.specializationConstantIds.insert(merged.specializationConstantIds.end(), stage.specializationConstantIds.begin(), stage.specializationConstantIds.end());
+
+			if (stage.stageFlags == VK_SHADER_STAGE_VERTEX_BIT && merged.vertexInputs.empty())
+			{
+				merged.vertexInputs = stage.vertexInputs;
+			}
+		}
+
+		std::sort(merged.specializationConstantIds.begin(), merged.specializationConstantIds.end());
+		merged.specializationConstantIds.erase(std::unique(merged.specializationConstantIds.begin(), merged.specializationConstantIds.end()), merged.specializationConstantIds.end());
+
+		for (const auto& [key, binding] : bindings)
+		{
+			merged.bindings.push_back(binding);
+		}
+
+		for (const auto& [stageFlags, range] : pushConstants)
+		{
+			auto found = std::find_if(merged.pushConstantRanges.begin(), merged.pushConstantRanges.end(), [&range = range](const auto& existing)
+				{
+					return existing.offset == range.first && existing.size == range.second - range.first;
+				});
+			if (found != merged.pushConstantRanges.end())
+			{
+				found->stageFlags |= stageFlags;
+			}
+			else
+			{
+				merged.pushConstantRanges.push_back({ stageFlags, range.first, range.second - range.first });
+			}
+		}
+		return result;
+	}
+
+	std::vector<VkDescriptorSetLayout> SpirvReflection::createDescriptorSetLayouts(VkDevice device, const ShaderReflection& reflection)
+	{
+		uint32_t setCount = 0;
+		for (const auto& binding : reflection.bindings)
+		{
+			setCount = std::max(setCount, binding.set + 1);
+		}
+
+		std::vector<VkDescriptorSetLayout> setLayouts(setCount, 0ull);
+		for (uint32_t set = 0; set < setCount; ++set)
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			for (const auto& binding : reflection.bindings)
+			{
+				if (binding.set != set)
+				{
+					continue;
+				}
+				VkDescriptorSetLayoutBinding layoutBinding{};
+				layoutBinding.binding = binding.binding;
+				layoutBinding.descriptorType = binding.descriptorType;
+				layoutBinding.descriptorCount = binding.descriptorCount;
+				layoutBinding.stageFlags = binding.stageFlags;
+				bindings.push_back(layoutBinding);
+			}
+
+			VkDescriptorSetLayoutCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+			createInfo.pBindings = bindings.data();
+			vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &setLayouts[set]);
+		}
+		return setLayouts;
+	}
+
+	VkPipelineLayout SpirvReflection::createPipelineLayout(VkDevice device, const ShaderReflection& reflection, const std::vector<VkDescriptorSetLayout>& setLayouts)
+	{
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(reflection.pushConstantRanges.size());
+		pipelineLayoutCreateInfo.pPushConstantRanges = reflection.pushConstantRanges.data();
+
+		VkPipelineLayout pipelineLayout = 0ull;
+		vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+		return pipelineLayout;
+	}
+
+	std::vector<VkDescriptorPoolSize> SpirvReflection::getDescriptorPoolSizes(const ShaderReflection& reflection, uint32_t set, uint32_t setCount)
+	{
+		std::map<VkDescriptorType, uint32_t> counts;
+		for (const auto& binding : reflection.bindings)
+		{
+			if (binding.set == set)
+			{
+				counts[binding.descriptorType] += binding.descriptorCount * setCount;
+			}
+		}
+
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& [type, count] : counts)
+		{
+			poolSizes.push_back({ type, count });
+		}
+		return poolSizes;
+	}
+
+	bool SpirvReflection::validateVertexInputs(
+		const ShaderReflection& reflection,
+		const std::vector<VkVertexInputBindingDescription>& bindings,
+		const std::vector<VkVertexInputAttributeDescription>& attributes,
+		const std::string& name
+	)
+	{
+		std::stringstream ss;
+		for (const auto& input : reflection.vertexInputs)
+		{
+			auto attribute = std::find_if(attributes.begin(), attributes.end(), [&input](const auto& attribute) { return attribute.location == input.location; });
+			if (attribute == attributes.end())
+			{
+				ss << name << ": location " << input.location << " is read by the shader but no attribute feeds it." << std::endl;
+				continue;
+			}
+
+			FormatInfo format{};
+			if (!getFormatInfo(attribute->format, format))
+			{
+				continue;
+			}
+			if (format.numericType != input.numericType)
+			{
+				ss << name << ": location " << input.location << " format " << attribute->format << " does not match the numeric type the shader reads." << std::endl;
+			}
+			//NOTE:Fewer components are filled in with (0, 0, 1) by the input assembler, more are fetched and thrown away.
+			if (format.componentCount > input.componentCount)
+			{
+				ss << name << ": location " << input.location << " format has " << format.componentCount << " components, the shader reads " << input.componentCount << "." << std::endl;
+			}
+		}
+
+		for (const auto& attribute : attributes)
+		{
+			FormatInfo format{};
+			auto binding = std::find_if(bindings.begin(), bindings.end(), [&attribute](const auto& binding) { return binding.binding == attribute.binding; });
+			if (binding == bindings.end())
+			{
+				ss << name << ": location " << attribute.location << " uses binding " << attribute.binding << " which is not declared." << std::endl;
+			}
+			else if (getFormatInfo(attribute.format, format) && attribute.offset + format.size > binding->stride)
+			{
+				ss << name << ": location " << attribute.location << " reads past the " << binding->stride << " byte stride of binding " << attribute.binding << "." << std::endl;
+			}
+		}
+
+		const auto messages = ss.str();
+		if (messages.empty())
+		{
+			return true;
+		}
+		OutputDebugStringA(messages.c_str());
+		return false;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> SpirvReflection::stripUnusedAttributes(
+		const ShaderReflection& reflection,
+		const std::vector<VkVertexInputAttributeDescription>& attributes
+	)
+	{
+		std::vector<VkVertexInputAttributeDescription> result;
+		for (const auto& attribute : attributes)
+		{
+			auto used = std::any_of(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [&attribute](const auto& input) { return input.location == attribute.location; });
+			if (used)
+			{
+				result.push_back(attribute);
+			}
+		}
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace app
+{
+	//NOTE:A resource declared with layout(set, binding). stageFlags holds every stage that uses it once merged.
+	struct ReflectedBinding
+	{
+		uint32_t set;
+		uint32_t binding;
+		VkDescriptorType descriptorType;
+		uint32_t descriptorCount;
+		VkShaderStageFlags stageFlags;
+	};
+
+	enum class ReflectedNumericType
+	{
+		Float,
+		Int,
+		Uint,
+	};
+
+	//NOTE:A vertex shader input. Matrices are split into one input per column location.
+	struct ReflectedVertexInput
+	{
+		uint32_t location;
+		ReflectedNumericType numericType;
+		uint32_t componentCount;
+	};
+
+	struct ShaderReflection
+	{
+		VkShaderStageFlags stageFlags = 0;
+		std::vector<ReflectedBinding> bindings;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		//NOTE:Vertex stage only, sorted by location. Built-ins are left out.
+		std::vector<ReflectedVertexInput> vertexInputs;
+		//NOTE:constant_id of every specialization constant the stage declares, sorted.
+		std::vector<uint32_t> specializationConstantIds;
+	};
+
+	//NOTE:Reads just enough of the SPIR-V binary to derive descriptor set layouts, push constant ranges
+	//     and vertex inputs, so the layouts follow the shaders instead of being written out per app.
+	class SpirvReflection
+	{
+	public:
+		//NOTE:Returns false when the code is not SPIR-V or has no entry point.
+		static bool reflect(const std::vector<uint32_t>& code, ShaderReflection& reflection);
+
+		//NOTE:Bindings are merged by (set, binding) with their stage flags combined, vertex inputs are kept from the vertex stage
+		//     and specialization constant IDs are the union.
+		//     Push constant ranges are merged per stage, stages with identical ranges share one.
+		//     Returns false when two stages disagree on a binding, the first declaration is kept.
+		static bool merge(const std::vector<ShaderReflection>& stages, ShaderReflection& merged);
+
+		//NOTE:One layout per set up to the highest set used, sets nothing binds get an empty layout.
+		static std::vector<VkDescriptorSetLayout> createDescriptorSetLayouts(VkDevice device, const ShaderReflection& reflection);
+		static VkPipelineLayout createPipelineLayout(VkDevice device, const ShaderReflection& reflection, const std::vector<VkDescriptorSetLayout>& setLayouts);
+		//NOTE:Enough descriptors of each type for setCount sets of the given set.
+		static std::vector<VkDescriptorPoolSize> getDescriptorPoolSizes(const ShaderReflection& reflection, uint32_t set, uint32_t setCount);
+
+		//NOTE:Logs every shader input the attributes do not feed, feed with another numeric type or with more components
+		//     than the shader reads, and every attribute that reads past the stride of its binding.
+		static bool validateVertexInputs(
+			const ShaderReflection& reflection,
+			const std::vector<VkVertexInputBindingDescription>& bindings,
+			const std::vector<VkVertexInputAttributeDescription>& attributes,
+			const std::string& name
+		);
+
+		//NOTE:Drops the attributes the vertex shader never reads, so they are not fetched.
+		static std::vector<VkVertexInputAttributeDescription> stripUnusedAttributes(
+			const ShaderReflection& reflection,
+			const std::vector<VkVertexInputAttributeDescription>& attributes
+		);
+	};
+}
\ No newline at end of file
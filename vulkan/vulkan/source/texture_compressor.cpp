@@ -0,0 +1,279 @@
+#include "texture_compressor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace app
+{
+	namespace
+	{
+		constexpr uint32_t BLOCK_DIMENSION = 4;
+		constexpr uint32_t POWER_ITERATIONS = 4;
+
+		uint16_t packRgb565(const float* color)
+		{
+			const auto r = static_cast<uint32_t>(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+			const auto g = static_cast<uint32_t>(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+			const auto b = static_cast<uint32_t>(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void unpackRgb565(uint16_t packed, int* color)
+		{
+			const auto r = (packed >> 11) & 31;
+			const auto g = (packed >> 5) & 63;
+			const auto b = packed & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		//NOTE:Gathers the 4x4 block at (blockX, blockY), clamping at the right and bottom edges.
+		void fetchBlock(const uint8_t* pixels, const MipLevel& level, uint32_t blockX, uint32_t blockY, uint8_t* texels)
+		{
+			for (uint32_t y = 0; y < BLOCK_DIMENSION; ++y)
+			{
+				const auto sourceY = std::min(blockY * BLOCK_DIMENSION + y, level.height - 1);
+				for (uint32_t x = 0; x < BLOCK_DIMENSION; ++x)
+				{
+					const auto sourceX = std::min(blockX * BLOCK_DIMENSION + x, level.width - 1);
+					std::memcpy(texels + (y * BLOCK_DIMENSION + x) * 4, pixels + level.offset + (static_cast<size_t>(sourceY) * level.width + sourceX) * 4, 4);
+				}
+			}
+		}
+	}
+
+	TextureData TextureCompressor::compress(const MipChain& source)
+	{
+		TextureData texture{};
+		texture.vkFormat = hasAlpha(source) ? FORMAT_BC3_UNORM : FORMAT_BC1_RGB_UNORM;
+
+		const auto blockSize = getBlockSize(texture.vkFormat);
+		const auto alpha = texture.vkFormat == FORMAT_BC3_UNORM;
+
+		size_t size = 0;
+		for (const auto& level : source.levels)
+		{
+			const auto blockCountX = (level.width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+			const auto blockCountY = (level.height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+			texture.mips.levels.push_back(MipLevel{ level.width, level.height, size });
+			size += static_cast<size_t>(blockCountX) * blockCountY * blockSize;
+		}
+		texture.mips.pixels.resize(size);
+
+		uint8_t texels[BLOCK_DIMENSION * BLOCK_DIMENSION * 4];
+		for (size_t i = 0; i < source.levels.size(); ++i)
+		{
+			const auto& level = source.levels[i];
+			auto* block = texture.mips.pixels.data() + texture.mips.levels[i].offset;
+
+			const auto blockCountX = (level.width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+			const auto blockCountY = (level.height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+			for (uint32_t blockY = 0; blockY < blockCountY; ++blockY)
+			{
+				for (uint32_t blockX = 0; blockX < blockCountX; ++blockX)
+				{
+					fetchBlock(source.pixels.data(), level, blockX, blockY, texels);
+					if (alpha)
+					{
+						encodeAlphaBlock(texels, block);
+						encodeColorBlock(texels, block + 8);
+					}
+					else
+					{
+						encodeColorBlock(texels, block);
+					}
+					block += blockSize;
+				}
+			}
+		}
+
+		return texture;
+	}
+
+	bool TextureCompressor::hasAlpha(const MipChain& source)
+	{
+		if (source.levels.empty())
+		{
+			return false;
+		}
+
+		const auto& level = source.levels.front();
+		const auto* pixels = source.pixels.data() + level.offset;
+		const auto texelCount = static_cast<size_t>(level.width) * level.height;
+		for (size_t i = 0; i < texelCount; ++i)
+		{
+			if (pixels[i * 4 + 3] != 0xff)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	uint32_t TextureCompressor::getBlockSize(uint32_t vkFormat)
+	{
+		return vkFormat == FORMAT_BC1_RGB_UNORM ? 8u : 16u;
+	}
+
+	void TextureCompressor::encodeColorBlock(const uint8_t* texels, uint8_t* block)
+	{
+		//NOTE:Endpoints are the extremes of the block along its principal axis.
+		float mean[3]{};
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				mean[c] += texels[i * 4 + c];
+			}
+		}
+		for (auto& m : mean)
+		{
+			m /= 16.0f;
+		}
+
+		float covariance[6]{};
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const float r = texels[i * 4 + 0] - mean[0];
+			const float g = texels[i * 4 + 1] - mean[1];
+			const float b = texels[i * 4 + 2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (uint32_t iteration = 0; iteration < POWER_ITERATIONS; ++iteration)
+		{
+			const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			const auto length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+			if (length <= 0.0f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		auto minProjection = 0.0f, maxProjection = 0.0f;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const auto projection =
+				(texels[i * 4 + 0] - mean[0]) * axis[0] +
+				(texels[i * 4 + 1] - mean[1]) * axis[1] +
+				(texels[i * 4 + 2] - mean[2]) * axis[2];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		const auto axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float maxColor[3]{}, minColor[3]{};
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			const auto direction = axisLengthSquared > 0.0f ? axis[c] / axisLengthSquared : 0.0f;
+			maxColor[c] = mean[c] + direction * maxProjection;
+			minColor[c] = mean[c] + direction * minProjection;
+		}
+
+		auto color0 = packRgb565(maxColor);
+		auto color1 = packRgb565(minColor);
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		//NOTE:color0 > color1 selects the four color mode, equal endpoints only ever use index 0.
+		int palette[4][3]{};
+		unpackRgb565(color0, palette[0]);
+		unpackRgb565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				auto bestIndex = 0u;
+				auto bestDistance = INT32_MAX;
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					const auto r = texels[i * 4 + 0] - palette[p][0];
+					const auto g = texels[i * 4 + 1] - palette[p][1];
+					const auto b = texels[i * 4 + 2] - palette[p][2];
+					const auto distance = r * r + g * g + b * b;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		block[0] = static_cast<uint8_t>(color0 & 0xff);
+		block[1] = static_cast<uint8_t>(color0 >> 8);
+		block[2] = static_cast<uint8_t>(color1 & 0xff);
+		block[3] = static_cast<uint8_t>(color1 >> 8);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			block[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+
+	void TextureCompressor::encodeAlphaBlock(const uint8_t* texels, uint8_t* block)
+	{
+		uint8_t alpha0 = 0, alpha1 = 0xff;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			alpha0 = std::max(alpha0, texels[i * 4 + 3]);
+			alpha1 = std::min(alpha1, texels[i * 4 + 3]);
+		}
+
+		//NOTE:alpha0 > alpha1 selects the eight value mode.
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 1; p < 7; ++p)
+		{
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				auto bestIndex = 0ull;
+				auto bestDistance = INT32_MAX;
+				for (uint32_t p = 0; p < 8; ++p)
+				{
+					const auto distance = std::abs(texels[i * 4 + 3] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (i * 3);
+			}
+		}
+
+		block[0] = alpha0;
+		block[1] = alpha1;
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+}
\ No newline at end of file
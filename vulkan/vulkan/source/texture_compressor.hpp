@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mipmap_builder.hpp"
+
+namespace app
+{
+	//NOTE:A whole mip chain in one Vulkan format, the unit stored in a KTX2 file.
+	//     vkFormat is a VkFormat value kept as an integer so CPU side code does not pull in Vulkan.
+	struct TextureData
+	{
+		uint32_t vkFormat = 0;
+		MipChain mips;
+	};
+
+	//NOTE:Encodes RGBA8 mip chains to 4x4 block compressed formats.
+	//     Edge blocks of levels that are not a multiple of 4 repeat the last row / column.
+	class TextureCompressor
+	{
+	public:
+		static constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 37;   // VK_FORMAT_R8G8B8A8_UNORM
+		static constexpr uint32_t FORMAT_BC1_RGB_UNORM = 131;   // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		static constexpr uint32_t FORMAT_BC3_UNORM = 137;       // VK_FORMAT_BC3_UNORM_BLOCK
+
+		//NOTE:Bumped whenever the encoder output changes so cooked textures are rebuilt.
+		static constexpr uint32_t VERSION = 1;
+
+		//NOTE:BC3 when any texel is translucent, BC1 otherwise.
+		static TextureData compress(const MipChain& source);
+
+		static bool hasAlpha(const MipChain& source);
+		static uint32_t getBlockSize(uint32_t vkFormat);
+
+		//NOTE:texels are 16 RGBA8 values in row order.
+		static void encodeColorBlock(const uint8_t* texels, uint8_t* block);
+		static void encodeAlphaBlock(const uint8_t* texels, uint8_t* block);
+	};
+}
\ No newline at end of file
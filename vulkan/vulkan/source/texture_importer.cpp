@@ -0,0 +1,137 @@
+#include "texture_importer.hpp"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define APP_TEXTURE_IMPORTER_SSE2
+#endif
+
+namespace app
+{
+	ImportedImage TextureImporter::import(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb)
+	{
+		const auto texelCount = static_cast<size_t>(width) * height;
+
+		ImportedImage image{};
+		image.channelCount = getRequiredChannelCount(rgba, texelCount);
+		image.pixels.resize(texelCount * image.channelCount);
+		switch (image.channelCount)
+		{
+		case 1:
+			image.vkFormat = srgb ? FORMAT_R8_SRGB : FORMAT_R8_UNORM;
+			extractChannels(rgba, texelCount, 1, image.pixels.data());
+			break;
+		case 2:
+			//NOTE:The sRGB curve only applies to R and G, so grey + alpha can not be sRGB without touching alpha.
+			if (srgb)
+			{
+				image.channelCount = 4;
+				image.vkFormat = FORMAT_R8G8B8A8_SRGB;
+				image.pixels.assign(rgba, rgba + texelCount * 4);
+				break;
+			}
+			image.vkFormat = FORMAT_R8G8_UNORM;
+			extractChannels(rgba, texelCount, 2, image.pixels.data());
+			break;
+		default:
+			image.vkFormat = srgb ? FORMAT_R8G8B8A8_SRGB : FORMAT_R8G8B8A8_UNORM;
+			std::memcpy(image.pixels.data(), rgba, texelCount * 4);
+			break;
+		}
+		return image;
+	}
+
+	uint32_t TextureImporter::getRequiredChannelCount(const uint8_t* rgba, size_t texelCount)
+	{
+		auto grey = true;
+		auto opaque = true;
+		size_t i = 0;
+
+#if defined(APP_TEXTURE_IMPORTER_SSE2)
+		//NOTE:Four texels per register, each 32 bit lane reads as r | g << 8 | b << 16 | a << 24.
+		const auto byteMask = _mm_set1_epi32(0xff);
+		const auto alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000u));
+		auto greyMask = _mm_set1_epi32(-1);
+		auto opaqueMask = _mm_set1_epi32(-1);
+		for (; i + 4 <= texelCount; i += 4)
+		{
+			const auto texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+			const auto r = _mm_and_si128(texels, byteMask);
+			const auto g = _mm_and_si128(_mm_srli_epi32(texels, 8), byteMask);
+			const auto b = _mm_and_si128(_mm_srli_epi32(texels, 16), byteMask);
+			greyMask = _mm_and_si128(greyMask, _mm_and_si128(_mm_cmpeq_epi32(r, g), _mm_cmpeq_epi32(r, b)));
+			opaqueMask = _mm_and_si128(opaqueMask, _mm_cmpeq_epi32(_mm_and_si128(texels, alphaMask), alphaMask));
+		}
+		grey = _mm_movemask_epi8(greyMask) == 0xffff;
+		opaque = _mm_movemask_epi8(opaqueMask) == 0xffff;
+#endif
+
+		for (; i < texelCount; ++i)
+		{
+			const auto* texel = rgba + i * 4;
+			grey = grey && texel[0] == texel[1] && texel[0] == texel[2];
+			opaque = opaque && texel[3] == 0xff;
+		}
+
+		if (!grey)
+		{
+			return 4;
+		}
+		return opaque ? 1 : 2;
+	}
+
+	void TextureImporter::extractChannels(const uint8_t* rgba, size_t texelCount, uint32_t channelCount, uint8_t* destination)
+	{
+		size_t i = 0;
+
+#if defined(APP_TEXTURE_IMPORTER_SSE2)
+		const auto byteMask = _mm_set1_epi32(0xff);
+		if (channelCount == 1)
+		{
+			//NOTE:16 texels -> 16 bytes. Every lane is <= 0xff so the saturating packs are exact.
+			for (; i + 16 <= texelCount; i += 16)
+			{
+				const auto* source = reinterpret_cast<const __m128i*>(rgba + i * 4);
+				const auto r0 = _mm_and_si128(_mm_loadu_si128(source + 0), byteMask);
+				const auto r1 = _mm_and_si128(_mm_loadu_si128(source + 1), byteMask);
+				const auto r2 = _mm_and_si128(_mm_loadu_si128(source + 2), byteMask);
+				const auto r3 = _mm_and_si128(_mm_loadu_si128(source + 3), byteMask);
+				const auto packed = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+			}
+		}
+		else if (channelCount == 2)
+		{
+			//NOTE:8 texels -> 16 bytes. r | a << 8 does not fit a signed 16 bit pack, so it is biased around it.
+			const auto bias32 = _mm_set1_epi32(0x8000);
+			const auto bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+			const auto alphaMask = _mm_set1_epi32(0xff00);
+			for (; i + 8 <= texelCount; i += 8)
+			{
+				const auto* source = reinterpret_cast<const __m128i*>(rgba + i * 4);
+				const auto t0 = _mm_loadu_si128(source + 0);
+				const auto t1 = _mm_loadu_si128(source + 1);
+				const auto ra0 = _mm_or_si128(_mm_and_si128(t0, byteMask), _mm_and_si128(_mm_srli_epi32(t0, 16), alphaMask));
+				const auto ra1 = _mm_or_si128(_mm_and_si128(t1, byteMask), _mm_and_si128(_mm_srli_epi32(t1, 16), alphaMask));
+				const auto packed = _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(ra0, bias32), _mm_sub_epi32(ra1, bias32)), bias16);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 2), packed);
+			}
+		}
+#endif
+
+		for (; i < texelCount; ++i)
+		{
+			const auto* texel = rgba + i * 4;
+			if (channelCount == 1)
+			{
+				destination[i] = texel[0];
+			}
+			else
+			{
+				destination[i * 2 + 0] = texel[0];
+				destination[i * 2 + 1] = texel[3];
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace app
+{
+	//NOTE:Texels repacked into the smallest uncompressed format that holds the image without loss.
+	//     vkFormat is a VkFormat value kept as an integer, like TextureData.
+	struct ImportedImage
+	{
+		uint32_t vkFormat = 0;
+		uint32_t channelCount = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	//NOTE:grey + opaque -> R8, grey + alpha -> RG8 (alpha in G), anything else stays RGBA8.
+	//     Samplers see the original colors through the swizzle from getSwizzle.
+	class TextureImporter
+	{
+	public:
+		static constexpr uint32_t FORMAT_R8_UNORM = 9;           // VK_FORMAT_R8_UNORM
+		static constexpr uint32_t FORMAT_R8_SRGB = 15;           // VK_FORMAT_R8_SRGB
+		static constexpr uint32_t FORMAT_R8G8_UNORM = 16;        // VK_FORMAT_R8G8_UNORM
+		static constexpr uint32_t FORMAT_R8G8_SRGB = 22;         // VK_FORMAT_R8G8_SRGB
+		static constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 37;    // VK_FORMAT_R8G8B8A8_UNORM
+		static constexpr uint32_t FORMAT_R8G8B8A8_SRGB = 43;     // VK_FORMAT_R8G8B8A8_SRGB
+
+		//NOTE:rgba holds width * height RGBA8 texels as decoded by stb_image.
+		static ImportedImage import(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb);
+
+		//NOTE:1, 2 or 4, the fewest channels that keep every texel.
+		static uint32_t getRequiredChannelCount(const uint8_t* rgba, size_t texelCount);
+		//NOTE:Writes R (channelCount 1) or R and A (channelCount 2) of every texel.
+		static void extractChannels(const uint8_t* rgba, size_t texelCount, uint32_t channelCount, uint8_t* destination);
+	};
+}
\ No newline at end of file
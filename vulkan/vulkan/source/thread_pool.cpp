@@ -0,0 +1,56 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace app
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+		}
+
+		m_threads.reserve(threadCount);
+		for (auto i = 0u; i < threadCount; ++i)
+		{
+			m_threads.emplace_back([this]() { workerLoop(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		//NOTE:Tasks that have not started are dropped, their futures report broken_promise.
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+			m_tasks.clear();
+		}
+		m_condition.notify_all();
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+				if (m_stopping)
+				{
+					return;
+				}
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			task();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace app
+{
+	class ThreadPool
+	{
+	public:
+		//NOTE:0 picks one thread per core, leaving one for the render loop.
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<class Function>
+		auto enqueue(Function&& function) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+		{
+			using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+			auto future = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_stopping)
+				{
+					return future;
+				}
+				m_tasks.emplace_back([task]() { (*task)(); });
+			}
+			m_condition.notify_one();
+			return future;
+		}
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "triangle_app.hpp"
 #include <array>
-#include <fstream>
 
 namespace app
 {
@@ -55,108 +54,23 @@ namespace app
 			VkVertexInputAttributeDescription{1,0,VK_FORMAT_R32G32B32_SFLOAT,offsetof(Vertex,color)}
 		};
 
-		VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
-		pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-		pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexInputBindingDescription;
-		pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexInputAttributeDescription.size();
-		pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInputAttributeDescription.data();
-
-		const auto colorWriteAll =
-			VK_COLOR_COMPONENT_R_BIT |
-			VK_COLOR_COMPONENT_G_BIT |
-			VK_COLOR_COMPONENT_B_BIT |
-			VK_COLOR_COMPONENT_A_BIT;
-		VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
-		pipelineColorBlendAttachmentState.blendEnable = VK_TRUE;
-		pipelineColorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-		pipelineColorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-		pipelineColorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		pipelineColorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		pipelineColorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
-		pipelineColorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
-		pipelineColorBlendAttachmentState.colorWriteMask = colorWriteAll;
-		VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{};
-		pipelineColorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		pipelineColorBlendStateCreateInfo.attachmentCount = 1;
-		pipelineColorBlendStateCreateInfo.pAttachments = &pipelineColorBlendAttachmentState;
-
-		VkViewport viewport
-		{
-			0.0f, static_cast<float>(m_swapchainExtent.height),
-			static_cast<float>(m_swapchainExtent.width), -1.0f * m_swapchainExtent.height,
-			0.0f,1.0f
-		};
-
-		VkRect2D scissor =
-		{
-			{0,0},
-			m_swapchainExtent
-		};
-		VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{};
-		pipelineViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		pipelineViewportStateCreateInfo.viewportCount = 1;
-		pipelineViewportStateCreateInfo.pViewports = &viewport;
-		pipelineViewportStateCreateInfo.scissorCount = 1;
-		pipelineViewportStateCreateInfo.pScissors = &scissor;
-
-		VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
-		pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		pipelineInputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-		VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
-		pipelineRasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		pipelineRasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-		pipelineRasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
-		pipelineRasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		pipelineRasterizationStateCreateInfo.lineWidth = 1.0f;
-
-		VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{};
-		pipelineMultisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		pipelineMultisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-		VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{};
-		pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-		pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
-
-		std::vector<VkPipelineShaderStageCreateInfo> pipelineShaderStageCreateInfos
-		{
-			loadShaderModule("source/triangle.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
-			loadShaderModule("source/triangle.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
-		};
-
 		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
 		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
 
-		VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{};
-		graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		graphicsPipelineCreateInfo.stageCount = pipelineShaderStageCreateInfos.size();
-		graphicsPipelineCreateInfo.pStages = pipelineShaderStageCreateInfos.data();
-		graphicsPipelineCreateInfo.pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo;
-		graphicsPipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
-		graphicsPipelineCreateInfo.pRasterizationState = &pipelineRasterizationStateCreateInfo;
-		graphicsPipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilStateCreateInfo;
-		graphicsPipelineCreateInfo.pMultisampleState = &pipelineMultisampleStateCreateInfo;
-		graphicsPipelineCreateInfo.pViewportState = &pipelineViewportStateCreateInfo;
-		graphicsPipelineCreateInfo.pColorBlendState = &pipelineColorBlendStateCreateInfo;
-		graphicsPipelineCreateInfo.renderPass = m_renderPass;
-		graphicsPipelineCreateInfo.layout = m_pipelineLayout;
-		vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &m_pipeline);
-
-		for (const auto& shaderStage : pipelineShaderStageCreateInfos)
-		{
-			vkDestroyShaderModule(m_device, shaderStage.module, nullptr);
-		}
+		PipelineState pipelineState{};
+		pipelineState.vertexShader = "source/triangle.vert.spv";
+		pipelineState.fragmentShader = "source/triangle.frag.spv";
+		pipelineState.vertexBindings = { vertexInputBindingDescription };
+		pipelineState.vertexAttributes.assign(vertexInputAttributeDescription.begin(), vertexInputAttributeDescription.end());
+		pipelineState.layout = m_pipelineLayout;
+		pipelineState.renderPass = m_renderPass;
+		m_pipeline = m_pipelineRegistry.getPipeline(pipelineState);
 	}
 
 	void TriangleApp::cleanup()
 	{
 		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-		vkDestroyPipeline(m_device, m_pipeline, nullptr);
 
 		vkFreeMemory(m_device, m_vertexBuffer.deviceMemory, nullptr);
 		vkFreeMemory(m_device, m_indexBuffer.deviceMemory, nullptr);
@@ -175,6 +89,15 @@ namespace app
 		vkCmdDrawIndexed(command, m_indexCount, 1, 0, 0, 0);
 	}
 
+	void TriangleApp::onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced)
+	{
+		auto found = replaced.find(m_pipeline);
+		if (found != replaced.end())
+		{
+			m_pipeline = found->second;
+		}
+	}
+
 	TriangleApp::BufferObject TriangleApp::createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags) const
 	{
 		BufferObject bufferObject{};
@@ -200,36 +123,4 @@ namespace app
 
 		return bufferObject;
 	}
-
-	VkPipelineShaderStageCreateInfo TriangleApp::loadShaderModule(const std::string& fileName, VkShaderStageFlagBits stage)
-	{
-		std::ifstream infile( fileName, std::ios::binary);
-
-		if (!infile)
-		{
-			OutputDebugStringA(fileName.data());
-			OutputDebugStringA("file not found.\n");
-			DebugBreak();
-		}
-
-		std::vector<char>filedata;
-		filedata.resize(static_cast<uint32_t>(infile.seekg(0, std::ifstream::end).tellg()));
-		infile.seekg(0, std::ifstream::beg).read(filedata.data(), filedata.size());
-
-		VkShaderModule shaderModule = 0ull;
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = reinterpret_cast<uint32_t*>(filedata.data());
-		shaderModuleCreateInfo.codeSize = filedata.size();
-		vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &shaderModule);
-
-		VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
-		pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		pipelineShaderStageCreateInfo.stage = stage;
-		pipelineShaderStageCreateInfo.module = shaderModule;
-		pipelineShaderStageCreateInfo.pName = "main";
-
-		return pipelineShaderStageCreateInfo;
-	}
-}
-
+}
\ No newline at end of file
@@ -28,11 +28,11 @@ namespace app
 		virtual void prepare() override;
 		virtual void cleanup() override;
 		virtual void makeCommand(VkCommandBuffer command) override;
+		virtual void onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced) override;
 
 	private:
 
 		BufferObject createBuffer(uint32_t size, VkBufferUsageFlags bufferUsageFlags) const;
-		VkPipelineShaderStageCreateInfo loadShaderModule(const std::string& fileName, VkShaderStageFlagBits stage);
 
 		BufferObject m_vertexBuffer{};
 		BufferObject m_indexBuffer{};
@@ -40,6 +40,7 @@ namespace app
 		uint32_t m_indexCount = 0;
 
 		VkPipelineLayout m_pipelineLayout = 0ull;
+		//NOTE:Owned by m_pipelineRegistry.
 		VkPipeline m_pipeline = 0ull;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "vertex_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace app
+{
+	PositionDequantization VertexQuantizer::computeDequantization(const std::vector<ModelVertex>& vertices)
+	{
+		PositionDequantization dequantization{ glm::vec4(0.0f), glm::vec4(1.0f) };
+		if (vertices.empty())
+		{
+			return dequantization;
+		}
+
+		auto minimum = vertices.front().position;
+		auto maximum = vertices.front().position;
+		for (const auto& vertex : vertices)
+		{
+			minimum = glm::min(minimum, vertex.position);
+			maximum = glm::max(maximum, vertex.position);
+		}
+
+		const auto center = (minimum + maximum) * 0.5f;
+		auto extent = (maximum - minimum) * 0.5f;
+		for (auto i = 0; i < 3; ++i)
+		{
+			//NOTE:Flat axes still need a non zero scale to stay invertible.
+			extent[i] = std::max(extent[i], 1.0e-6f);
+		}
+
+		dequantization.offset = glm::vec4(center, 0.0f);
+		dequantization.scale = glm::vec4(extent, 1.0f);
+		return dequantization;
+	}
+
+	std::vector<CompactVertex> VertexQuantizer::quantize(const std::vector<ModelVertex>& vertices, const PositionDequantization& dequantization)
+	{
+		std::vector<CompactVertex> result(vertices.size());
+		for (auto i = 0u; i < vertices.size(); ++i)
+		{
+			const auto& vertex = vertices[i];
+			auto& compact = result[i];
+
+			for (auto axis = 0; axis < 3; ++axis)
+			{
+				const auto normalized = (vertex.position[axis] - dequantization.offset[axis]) / dequantization.scale[axis];
+				compact.position[axis] = floatToSnorm16(normalized);
+			}
+			compact.position[3] = 0;
+
+			compact.uv[0] = floatToHalf(vertex.uv.x);
+			compact.uv[1] = floatToHalf(vertex.uv.y);
+		}
+		return result;
+	}
+
+	uint16_t VertexQuantizer::floatToHalf(float value)
+	{
+		uint32_t bits = 0;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+		const auto exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+		auto mantissa = bits & 0x7fffffu;
+
+		if (((bits >> 23) & 0xffu) == 0xffu)
+		{
+			//NOTE:Inf / NaN
+			return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+		}
+		if (exponent >= 31)
+		{
+			return static_cast<uint16_t>(sign | 0x7c00u);
+		}
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return sign;
+			}
+			//NOTE:Denormal, shift the implicit one into the mantissa.
+			mantissa |= 0x800000u;
+			const auto shift = static_cast<uint32_t>(14 - exponent);
+			auto half = mantissa >> shift;
+			const auto remainder = mantissa & ((1u << shift) - 1u);
+			const auto halfway = 1u << (shift - 1u);
+			if (remainder > halfway || (remainder == halfway && (half & 1u)))
+			{
+				++half;
+			}
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		auto half = static_cast<uint32_t>(exponent << 10) | (mantissa >> 13);
+		const auto remainder = mantissa & 0x1fffu;
+		if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+		{
+			//NOTE:Carry may ripple into the exponent which is the correct rounding.
+			++half;
+		}
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	int16_t VertexQuantizer::floatToSnorm16(float value)
+	{
+		const auto clamped = std::min(std::max(value, -1.0f), 1.0f);
+		return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+	}
+
+	VertexStreams VertexStreamSplitter::split(const std::vector<ModelVertex>& vertices)
+	{
+		VertexStreams streams{};
+		streams.positions.resize(sizeof(glm::vec3) * vertices.size());
+		streams.attributes.resize(sizeof(VertexAttributes) * vertices.size());
+
+		auto* positions = reinterpret_cast<glm::vec3*>(streams.positions.data());
+		auto* attributes = reinterpret_cast<VertexAttributes*>(streams.attributes.data());
+		for (auto i = 0u; i < vertices.size(); ++i)
+		{
+			positions[i] = vertices[i].position;
+			attributes[i] = VertexAttributes{ vertices[i].color, vertices[i].uv };
+		}
+		return streams;
+	}
+
+	VertexStreams VertexStreamSplitter::split(const std::vector<CompactVertex>& vertices)
+	{
+		VertexStreams streams{};
+		streams.positions.resize(sizeof(CompactVertex::position) * vertices.size());
+		streams.attributes.resize(sizeof(CompactVertexAttributes) * vertices.size());
+
+		auto* attributes = reinterpret_cast<CompactVertexAttributes*>(streams.attributes.data());
+		for (auto i = 0u; i < vertices.size(); ++i)
+		{
+			std::memcpy(streams.positions.data() + sizeof(CompactVertex::position) * i, vertices[i].position, sizeof(CompactVertex::position));
+			std::memcpy(attributes[i].uv, vertices[i].uv, sizeof(attributes[i].uv));
+		}
+		return streams;
+	}
+
+	uint32_t VertexStreamSplitter::getPositionStride(VertexFormat format)
+	{
+		return static_cast<uint32_t>(format == VertexFormat::Compact ? sizeof(CompactVertex::position) : sizeof(glm::vec3));
+	}
+
+	uint32_t VertexStreamSplitter::getAttributeStride(VertexFormat format)
+	{
+		return static_cast<uint32_t>(format == VertexFormat::Compact ? sizeof(CompactVertexAttributes) : sizeof(VertexAttributes));
+	}
+}
\ No newline at end of file
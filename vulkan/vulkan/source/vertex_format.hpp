@@ -0,0 +1,70 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+namespace app
+{
+	enum class VertexFormat
+	{
+		//NOTE:ModelVertex as is, 32 bytes.
+		Float32,
+		//NOTE:CompactVertex, 12 bytes.
+		Compact,
+	};
+
+	//NOTE:position : snorm16x4 relative to the mesh bounds (w unused)
+	//     uv       : half x2
+	//     No shader lights the model, so the normal (color in ModelVertex) is not carried.
+	struct CompactVertex
+	{
+		int16_t position[4];
+		uint16_t uv[2];
+	};
+
+	//NOTE:Attribute stream layouts used when positions live in their own binding.
+	struct VertexAttributes
+	{
+		glm::vec3 color;
+		glm::vec2 uv;
+	};
+
+	struct CompactVertexAttributes
+	{
+		uint16_t uv[2];
+	};
+
+	//NOTE:Binding 0 holds positions only, binding 1 the rest.
+	struct VertexStreams
+	{
+		std::vector<uint8_t> positions;
+		std::vector<uint8_t> attributes;
+	};
+
+	//NOTE:position = offset + quantized * scale
+	struct PositionDequantization
+	{
+		glm::vec4 offset;
+		glm::vec4 scale;
+	};
+
+	class VertexQuantizer
+	{
+	public:
+		static PositionDequantization computeDequantization(const std::vector<ModelVertex>& vertices);
+		static std::vector<CompactVertex> quantize(const std::vector<ModelVertex>& vertices, const PositionDequantization& dequantization);
+
+		static uint16_t floatToHalf(float value);
+		static int16_t floatToSnorm16(float value);
+	};
+
+	//NOTE:Depth only passes bind just the position stream, so they fetch 12 (Float32) or 8 (Compact) bytes per vertex.
+	class VertexStreamSplitter
+	{
+	public:
+		static VertexStreams split(const std::vector<ModelVertex>& vertices);
+		static VertexStreams split(const std::vector<CompactVertex>& vertices);
+
+		static uint32_t getPositionStride(VertexFormat format);
+		static uint32_t getAttributeStride(VertexFormat format);
+	};
+}
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "vulkan_app_base.hpp"
+#include "pipeline_cache_file.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <array>
@@ -66,12 +70,17 @@ namespace app
 
 		prepareCommandPool();
 
+		createPipelineCache();
+		m_shaderModuleCache.initialize(m_device);
+		m_pipelineRegistry.initialize(m_device, m_pipelineCache, m_shaderModuleCache, m_graphicsPipelineLibrarySupported);
+
 		glfwCreateWindowSurface(m_instance, window, nullptr, &m_surface);
 		selectSurfaceFormat( VK_FORMAT_B8G8R8A8_UNORM );
 		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &m_surfaceCapabilities);
 		VkBool32 isSuppoort = 0u;
 		vkGetPhysicalDeviceSurfaceSupportKHR(m_physicalDevice, m_graphicsQueueIndex, m_surface, &isSuppoort);
 
+		m_window = window;
 		createSwapchain(window);
 
 		createDepthBuffer();
@@ -87,36 +96,33 @@ namespace app
 		prepareSemaphores();
 
 		prepare();
+
+#ifdef _DEBUG
+		watchShaders();
+#endif // _DEBUG
 	}
 
 	void VulkanAppBase::terminate()
 	{
+		m_shaderCompileThreadPool.reset();
 		vkDeviceWaitIdle(m_device);
 
 		cleanup();
+		releaseRetiredResources(true);
+
+		m_pipelineRegistry.destroy();
+		m_shaderModuleCache.destroy();
+		savePipelineCache();
+		vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
 
 		vkFreeCommandBuffers(m_device, m_commandPool, m_commandBuffers.size(), m_commandBuffers.data());
 		m_commandBuffers.clear();
 		m_commandBuffers.shrink_to_fit();
 
 		vkDestroyRenderPass(m_device, m_renderPass, nullptr);
-		for (auto& frameBuffer : m_framebuffers)
-		{
-			vkDestroyFramebuffer(m_device, frameBuffer, nullptr);
-		}
-		m_framebuffers.clear();
-		m_framebuffers.shrink_to_fit();
-
-		vkFreeMemory(m_device, m_depthBufferMemory, nullptr);
-		vkDestroyImage(m_device, m_depthImage, nullptr);
-		vkDestroyImageView(m_device, m_depthImageView, nullptr);
-
-		for (auto& swapChainImageView : m_swapchainImageViews)
-		{
-			vkDestroyImageView(m_device, swapChainImageView, nullptr);
-		}
-		m_swapchainImageViews.clear();
+		destroySwapchainResources();
 		m_swapchainImageViews.shrink_to_fit();
+		m_framebuffers.shrink_to_fit();
 
 		vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
 
@@ -145,13 +151,52 @@ namespace app
 
 	void VulkanAppBase::render()
 	{
+		applyLoadedResources();
+
+#ifdef _DEBUG
+		reloadShaders();
+#endif // _DEBUG
+
+		//NOTE:Pipelines drawn fast linked so far switch to their optimized link once it is ready.
+		const auto optimized = m_pipelineRegistry.collectOptimizedPipelines([this](VkPipeline pipeline)
+			{
+				retireResource([this, pipeline]() { vkDestroyPipeline(m_device, pipeline, nullptr); });
+			});
+		if (!optimized.empty())
+		{
+			onPipelinesRebuilt(optimized);
+		}
+
+		//NOTE:Poll the window as well, not every platform reports a resize as OUT_OF_DATE.
+		auto width = 0;
+		auto height = 0;
+		glfwGetFramebufferSize(m_window, &width, &height);
+		if (width == 0 || height == 0)
+		{
+			//NOTE:Minimized, there is nothing to present to.
+			return;
+		}
+		if (m_swapchainOutOfDate || static_cast<uint32_t>(width) != m_swapchainExtent.width || static_cast<uint32_t>(height) != m_swapchainExtent.height)
+		{
+			recreateSwapchain();
+		}
 
 		uint32_t nextImageIndex = 0;
-		vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_presentCompletedSemaphore, VK_NULL_HANDLE, &nextImageIndex);
+		auto acquireResult = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_presentCompletedSemaphore, VK_NULL_HANDLE, &nextImageIndex);
+		if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			//NOTE:The semaphore is not signaled, skip the frame and draw into the new swapchain next time.
+			recreateSwapchain();
+			return;
+		}
 
 		auto fence = m_fences[nextImageIndex];
 		vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
 
+		//NOTE:A fence also covers every submission before it, so all frames up to this one are done.
+		m_completedFrameNumber = std::max(m_completedFrameNumber, m_submittedFrameNumbers[nextImageIndex]);
+		releaseRetiredResources();
+
 		std::array<VkClearValue, 2> clearValue =
 		{ {
 			{0.5f, 0.25f,0.25f,0.0f},
@@ -174,6 +219,21 @@ namespace app
 		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
+		//NOTE:Pipelines leave viewport and scissor dynamic. Y is flipped like every app here draws.
+		VkViewport viewport
+		{
+			0.0f, static_cast<float>(m_swapchainExtent.height),
+			static_cast<float>(m_swapchainExtent.width), -1.0f * m_swapchainExtent.height,
+			0.0f,1.0f
+		};
+		VkRect2D scissor =
+		{
+			{0,0},
+			m_swapchainExtent
+		};
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
 		m_imageIndex = nextImageIndex;
 		makeCommand(commandBuffer);
 
@@ -191,7 +251,10 @@ namespace app
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &m_renderCompletedSemaphore;
 		vkResetFences(m_device, 1, &fence);
+
+		std::lock_guard<std::mutex> queueLock(m_queueMutex);
 		vkQueueSubmit(m_deviceQueue, 1, &submitInfo, fence);
+		m_submittedFrameNumbers[nextImageIndex] = ++m_frameNumber;
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -200,7 +263,115 @@ namespace app
 		presentInfo.pImageIndices = &nextImageIndex;
 		presentInfo.waitSemaphoreCount = 1;
 		presentInfo.pWaitSemaphores = &m_renderCompletedSemaphore;
-		vkQueuePresentKHR(m_deviceQueue, &presentInfo);
+		auto presentResult = vkQueuePresentKHR(m_deviceQueue, &presentInfo);
+		if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+		{
+			m_swapchainOutOfDate = true;
+		}
+	}
+
+	void VulkanAppBase::recreateSwapchain()
+	{
+		//NOTE:Only objects sized by the swapchain are rebuilt. Render pass, pipelines and command buffers stay as they are.
+		{
+			std::lock_guard<std::mutex> queueLock(m_queueMutex);
+			vkDeviceWaitIdle(m_device);
+		}
+
+		const auto imageCount = m_swapchainImageViews.size();
+		destroySwapchainResources();
+
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &m_surfaceCapabilities);
+		createSwapchain(m_window);
+		createDepthBuffer();
+		createViews();
+		createFramebuffer();
+		m_swapchainOutOfDate = false;
+
+		//NOTE:Command buffers, fences and the apps' per image resources are sized by the image count.
+		//     The device is idle, so they can all be rebuilt in place.
+		if (m_swapchainImageViews.size() != imageCount)
+		{
+			std::stringstream ss;
+			ss << "swapchain image count changed on recreation: " << imageCount << " -> " << m_swapchainImageViews.size() << std::endl;
+			OutputDebugStringA(ss.str().c_str());
+
+			vkFreeCommandBuffers(m_device, m_commandPool, m_commandBuffers.size(), m_commandBuffers.data());
+			m_commandBuffers.clear();
+			for (auto& fence : m_fences)
+			{
+				vkDestroyFence(m_device, fence, nullptr);
+			}
+			m_fences.clear();
+			releaseRetiredResources(true);
+
+			prepareCommandBuffers();
+			prepareFences();
+			onSwapchainImageCountChanged();
+		}
+
+		std::stringstream ss;
+		ss << "swapchain recreated: " << m_swapchainExtent.width << "x" << m_swapchainExtent.height << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+	}
+
+	void VulkanAppBase::destroySwapchainResources()
+	{
+		for (auto& frameBuffer : m_framebuffers)
+		{
+			vkDestroyFramebuffer(m_device, frameBuffer, nullptr);
+		}
+		m_framebuffers.clear();
+
+		vkFreeMemory(m_device, m_depthBufferMemory, nullptr);
+		vkDestroyImage(m_device, m_depthImage, nullptr);
+		vkDestroyImageView(m_device, m_depthImageView, nullptr);
+
+		for (auto& swapChainImageView : m_swapchainImageViews)
+		{
+			vkDestroyImageView(m_device, swapChainImageView, nullptr);
+		}
+		m_swapchainImageViews.clear();
+	}
+
+	void VulkanAppBase::postLoadedResource(std::function<void()> apply)
+	{
+		std::lock_guard<std::mutex> lock(m_loadedResourcesMutex);
+		m_loadedResources.emplace_back(std::move(apply));
+	}
+
+	void VulkanAppBase::applyLoadedResources()
+	{
+		std::vector<std::function<void()>> loadedResources;
+		{
+			std::lock_guard<std::mutex> lock(m_loadedResourcesMutex);
+			loadedResources.swap(m_loadedResources);
+		}
+
+		for (auto& apply : loadedResources)
+		{
+			apply();
+		}
+	}
+
+	void VulkanAppBase::retireResource(std::function<void()> destroy)
+	{
+		//NOTE:The frame being recorded may still use it (uploads submitted ahead of it included), so wait for that one.
+		m_retiredResources.emplace_back(m_frameNumber + 1, std::move(destroy));
+	}
+
+	void VulkanAppBase::releaseRetiredResources(bool force)
+	{
+		while (!m_retiredResources.empty())
+		{
+			auto& retiredResource = m_retiredResources.front();
+			if (!force && retiredResource.first > m_completedFrameNumber)
+			{
+				break;
+			}
+			retiredResource.second();
+			m_retiredResources.pop_front();
+		}
 	}
 
 	void VulkanAppBase::checkResult( VkResult result )
@@ -269,6 +440,7 @@ namespace app
 
 		m_physicalDevice = physicalDevices[0];
 		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_physicalDeviceMemoryProperties);
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &m_physicalDeviceProperties);
 		
 	}
 
@@ -326,11 +498,55 @@ namespace app
 		//	extensions.push_back(deviceExtensionsProperty.extensionName);
 		//}
 
-		VkPhysicalDeviceFeatures physicalDeviceFeatures{};
-		vkGetPhysicalDeviceFeatures(m_physicalDevice, &physicalDeviceFeatures);
+		vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_physicalDeviceFeatures);
+
+		auto hasExtension = [&deviceExtensionsPropeties](const char* name)
+		{
+			return std::any_of(deviceExtensionsPropeties.begin(), deviceExtensionsPropeties.end(), [name](const auto& property) { return std::strcmp(property.extensionName, name) == 0; });
+		};
+
+		//NOTE:The instance is 1.0, the *2 queries come from VK_KHR_get_physical_device_properties2.
+		GetInstanceProcAddr(vkGetPhysicalDeviceFeatures2KHR);
+		GetInstanceProcAddr(vkGetPhysicalDeviceProperties2KHR);
+
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+		graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+		if (
+			hasExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+			hasExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+			m_vkGetPhysicalDeviceFeatures2KHR != nullptr &&
+			m_vkGetPhysicalDeviceProperties2KHR != nullptr
+			)
+		{
+			VkPhysicalDeviceFeatures2KHR features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+			features.pNext = &graphicsPipelineLibraryFeatures;
+			m_vkGetPhysicalDeviceFeatures2KHR(m_physicalDevice, &features);
+
+			VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties{};
+			graphicsPipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+			VkPhysicalDeviceProperties2KHR properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+			properties.pNext = &graphicsPipelineLibraryProperties;
+			m_vkGetPhysicalDeviceProperties2KHR(m_physicalDevice, &properties);
+
+			//NOTE:Without fast linking a link costs about as much as a full compile, nothing would be gained.
+			m_graphicsPipelineLibrarySupported =
+				graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE &&
+				graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+		}
+		if (m_graphicsPipelineLibrarySupported)
+		{
+			extensions.emplace_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			extensions.emplace_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+		}
+		//NOTE:Only the feature itself is enabled, the rest stays in pEnabledFeatures.
+		graphicsPipelineLibraryFeatures.pNext = nullptr;
+		graphicsPipelineLibraryFeatures.graphicsPipelineLibrary = m_graphicsPipelineLibrarySupported ? VK_TRUE : VK_FALSE;
 
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.pNext = m_graphicsPipelineLibrarySupported ? &graphicsPipelineLibraryFeatures : nullptr;
 
 		//NOTE:ppEnabledExtensionNames
 		//     g@\ɂĂVkPhysicalDeviceProperties2KvH
@@ -338,7 +554,7 @@ namespace app
 		deviceCreateInfo.enabledExtensionCount = extensions.size();
 		deviceCreateInfo.pQueueCreateInfos = &deviceQueueCreateInfo;
 		deviceCreateInfo.queueCreateInfoCount = 1;
-		deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
+		deviceCreateInfo.pEnabledFeatures = &m_physicalDeviceFeatures;
 
 		auto result = vkCreateDevice(m_physicalDevice, &deviceCreateInfo, nullptr, &m_device);
 		checkResult(result);
@@ -356,6 +572,173 @@ namespace app
 		checkResult(result);
 	}
 
+	void VulkanAppBase::createPipelineCache()
+	{
+		std::vector<uint8_t> initialData;
+		const auto loaded = PipelineCacheFile(PIPELINE_CACHE_FILE_NAME).load(m_physicalDeviceProperties, initialData);
+
+		{
+			std::stringstream ss;
+			ss << "pipeline cache: " << (loaded ? "loaded " : "cold, ") << initialData.size() << " bytes" << std::endl;
+			OutputDebugStringA(ss.str().c_str());
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = initialData.size();
+		createInfo.pInitialData = initialData.data();
+		auto result = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_pipelineCache);
+		checkResult(result);
+	}
+
+	void VulkanAppBase::savePipelineCache() const
+	{
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS)
+		{
+			return;
+		}
+
+		std::vector<uint8_t> data(dataSize);
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+		{
+			return;
+		}
+		data.resize(dataSize);
+
+		PipelineCacheFile(PIPELINE_CACHE_FILE_NAME).save(m_physicalDeviceProperties, data);
+	}
+
+	void VulkanAppBase::watchShaders()
+	{
+		for (const auto& fileName : m_pipelineRegistry.getShaderFileNames())
+		{
+			//NOTE:"source/model.vert.spv" is compiled from "source/model.vert".
+			const std::filesystem::path spirvPath(fileName);
+			m_shaderWatcher.watch(spirvPath);
+			m_shaderWatcher.watch(spirvPath.parent_path() / spirvPath.stem());
+		}
+		m_shaderCompileThreadPool = std::make_unique<ThreadPool>(1);
+	}
+
+	void VulkanAppBase::reloadShaders()
+	{
+		std::vector<std::filesystem::path> changedSpirvPaths;
+		for (const auto& path : m_shaderWatcher.poll())
+		{
+			if (path.extension() == ".spv")
+			{
+				if (m_compilingShaders.count(path) == 0)
+				{
+					changedSpirvPaths.push_back(path);
+				}
+				continue;
+			}
+
+			//NOTE:glslangValidator runs long enough to stall frames, so it runs on a worker.
+			auto spirvPath = path;
+			spirvPath += ".spv";
+			m_compilingShaders.insert(spirvPath);
+			m_shaderCompileThreadPool->enqueue([this, path, spirvPath]()
+				{
+					const auto compiled = compileShader(path, spirvPath);
+					postLoadedResource([this, spirvPath, compiled]()
+						{
+							m_compilingShaders.erase(m_compilingShaders.find(spirvPath));
+							if (compiled)
+							{
+								//NOTE:Rebaseline so the freshly written .spv does not count as a second change next poll.
+								m_shaderWatcher.watch(spirvPath);
+								reloadShader(spirvPath.generic_string());
+							}
+						});
+				});
+		}
+		std::sort(changedSpirvPaths.begin(), changedSpirvPaths.end());
+		changedSpirvPaths.erase(std::unique(changedSpirvPaths.begin(), changedSpirvPaths.end()), changedSpirvPaths.end());
+
+		for (const auto& spirvPath : changedSpirvPaths)
+		{
+			reloadShader(spirvPath.generic_string());
+		}
+	}
+
+	void VulkanAppBase::reloadShader(const std::string& fileName)
+	{
+		VkShaderModule replacedModule = 0ull;
+		if (m_shaderModuleCache.reload(fileName, replacedModule) == 0ull)
+		{
+			return;
+		}
+
+		//NOTE:Frames in flight may still use the old pipelines.
+		const auto replaced = m_pipelineRegistry.rebuildPipelines(fileName, [this](VkPipeline pipeline)
+			{
+				retireResource([this, pipeline]() { vkDestroyPipeline(m_device, pipeline, nullptr); });
+			});
+		if (!replaced.empty())
+		{
+			onPipelinesRebuilt(replaced);
+		}
+
+		//NOTE:Nothing is built from the old module anymore, it goes with the pipelines it was used for.
+		if (replacedModule != 0ull)
+		{
+			retireResource([this, replacedModule]() { vkDestroyShaderModule(m_device, replacedModule, nullptr); });
+		}
+
+		std::stringstream ss;
+		ss << "shader hot reload: " << fileName << ", " << replaced.size() << " pipelines rebuilt" << std::endl;
+		OutputDebugStringA(ss.str().c_str());
+	}
+
+	bool VulkanAppBase::compileShader(const std::filesystem::path& sourcePath, const std::filesystem::path& spirvPath) const
+	{
+		//NOTE:Same compiler and flags as the CustomBuild step. Without the SDK only .spv changes are picked up.
+		char sdkPath[MAX_PATH]{};
+		const auto length = GetEnvironmentVariableA("VK_SDK_PATH", sdkPath, MAX_PATH);
+		if (length == 0 || length >= MAX_PATH)
+		{
+			OutputDebugStringA("VK_SDK_PATH is not set, cannot compile shaders.\n");
+			return false;
+		}
+
+		const auto compilerPath = std::filesystem::path(sdkPath) / "Bin" / "glslangValidator.exe";
+		std::stringstream command;
+		//NOTE:cmd strips the outer quotes when the line starts with one.
+		command << "\"\"" << compilerPath.string() << "\" -V \"" << sourcePath.string() << "\" -o \"" << spirvPath.string() << "\"\"";
+		if (std::system(command.str().c_str()) != 0)
+		{
+			std::stringstream ss;
+			ss << "shader hot reload: " << sourcePath.generic_string() << " failed to compile" << std::endl;
+			OutputDebugStringA(ss.str().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	ShaderReflection VulkanAppBase::reflectShaders(const std::vector<std::string>& fileNames)
+	{
+		std::vector<ShaderReflection> stages;
+		for (const auto& fileName : fileNames)
+		{
+			ShaderReflection reflection;
+			if (!m_shaderModuleCache.getReflection(fileName, reflection))
+			{
+				DebugBreak();
+				continue;
+			}
+			stages.push_back(std::move(reflection));
+		}
+
+		ShaderReflection merged;
+		if (!SpirvReflection::merge(stages, merged))
+		{
+			DebugBreak();
+		}
+		return merged;
+	}
+
 	void VulkanAppBase::selectSurfaceFormat(VkFormat format)
 	{
 		uint32_t surfaceFormatCount = 0;
@@ -396,11 +779,15 @@ namespace app
 		swapchainCreateInfo.imageArrayLayers = 1;
 		swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		swapchainCreateInfo.presentMode = m_presentMode;
-		swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+		//NOTE:Null on the first call. On recreation the old one is retired here, its images are no longer in use.
+		swapchainCreateInfo.oldSwapchain = m_swapchain;
 		swapchainCreateInfo.clipped = VK_TRUE;
 		swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		auto result = vkCreateSwapchainKHR(m_device, &swapchainCreateInfo, nullptr, &m_swapchain);
+		VkSwapchainKHR swapchain = 0ull;
+		auto result = vkCreateSwapchainKHR(m_device, &swapchainCreateInfo, nullptr, &swapchain);
 		checkResult(result);
+		vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
+		m_swapchain = swapchain;
 		m_swapchainExtent = extent;
 	}
 
@@ -448,6 +835,58 @@ namespace app
 		return memoryTypeIndex;
 	}
 
+	bool VulkanAppBase::isLinearBlitSupported(VkFormat format) const
+	{
+		VkFormatProperties formatProperties{};
+		vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProperties);
+
+		const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (formatProperties.optimalTilingFeatures & required) == required;
+	}
+
+	void VulkanAppBase::generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels) const
+	{
+		auto transitionLevel = [commandBuffer, image](uint32_t level, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageFlags)
+		{
+			VkImageMemoryBarrier imageMemoryBarrier{};
+			imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageMemoryBarrier.oldLayout = oldLayout;
+			imageMemoryBarrier.newLayout = newLayout;
+			imageMemoryBarrier.srcAccessMask = srcAccessMask;
+			imageMemoryBarrier.dstAccessMask = dstAccessMask;
+			imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT,level,1,0,1 };
+			imageMemoryBarrier.image = image;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageFlags, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+		};
+
+		auto levelWidth = static_cast<int32_t>(width);
+		auto levelHeight = static_cast<int32_t>(height);
+		for (uint32_t level = 1; level < mipLevels; ++level)
+		{
+			//NOTE:The previous level has just been written (copy or blit), make it the blit source.
+			transitionLevel(level - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			const auto nextWidth = std::max(levelWidth / 2, 1);
+			const auto nextHeight = std::max(levelHeight / 2, 1);
+
+			VkImageBlit imageBlit{};
+			imageBlit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,level - 1,0,1 };
+			imageBlit.srcOffsets[1] = { levelWidth, levelHeight, 1 };
+			imageBlit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT,level,0,1 };
+			imageBlit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+			vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
+
+			transitionLevel(level - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+
+		transitionLevel(mipLevels - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
 	void VulkanAppBase::createViews()
 	{
 		createSwapchainViews();
@@ -593,6 +1032,7 @@ namespace app
 	void VulkanAppBase::prepareFences()
 	{
 		m_fences.resize(m_swapchainImageViews.size());
+		m_submittedFrameNumbers.assign(m_swapchainImageViews.size(), 0ull);
 		VkFenceCreateInfo fenceCreateInfo{};
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
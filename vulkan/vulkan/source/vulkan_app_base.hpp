@@ -13,6 +13,14 @@
 
 #pragma comment(lib, "vulkan-1.lib")
 
+#include "file_watcher.hpp"
+#include "pipeline_registry.hpp"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <vector>
 
 namespace app
@@ -29,6 +37,12 @@ namespace app
 		virtual void prepare() {}
 		virtual void cleanup() {}
 		virtual void makeCommand(VkCommandBuffer command) {}
+		//NOTE:Called at a frame boundary after a shader hot reload or when optimized links replace fast linked pipelines,
+		//     replace every handle found in replaced (old -> new).
+		virtual void onPipelinesRebuilt(const std::unordered_map<VkPipeline, VkPipeline>& replaced) {}
+		//NOTE:Called when a recreated swapchain has a different number of images, with the device idle.
+		//     Rebuild everything indexed by m_imageIndex.
+		virtual void onSwapchainImageCountChanged() {}
 
 		virtual void render();
 
@@ -46,14 +60,42 @@ namespace app
 
 		void prepareCommandPool();
 
+		//NOTE:Seeded from PIPELINE_CACHE_FILE_NAME when it matches this device and driver, written back at terminate.
+		void createPipelineCache();
+		void savePipelineCache() const;
+
+		//NOTE:Debug builds watch every shader the registry uses, its GLSL source and its SPIR-V.
+		//     A changed source is recompiled on m_shaderCompileThreadPool and reloaded once the result is posted back,
+		//     a changed .spv is reloaded right away. Only the pipelines built from it are rebuilt.
+		void watchShaders();
+		void reloadShaders();
+		void reloadShader(const std::string& fileName);
+		bool compileShader(const std::filesystem::path& sourcePath, const std::filesystem::path& spirvPath) const;
+
+		//NOTE:Safe on any thread. apply runs on the render thread at the start of the next frame.
+		void postLoadedResource(std::function<void()> apply);
+		//NOTE:Runs everything posted since the last frame. Apps that finish their own work at the frame boundary extend it.
+		virtual void applyLoadedResources();
+
+		//NOTE:Merged reflection of the given SPIR-V files, for the set and pipeline layouts shared by the pipelines built from them.
+		ShaderReflection reflectShaders(const std::vector<std::string>& fileNames);
+
 		void selectSurfaceFormat(VkFormat format);
 
 		void createSwapchain(GLFWwindow* window);
+		//NOTE:Rebuilds the swapchain, depth buffer and framebuffers at the current window size.
+		void recreateSwapchain();
+		void destroySwapchainResources();
 
 		void createDepthBuffer();
 
 		uint32_t getMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestMemoryPropertyFlags) const;
 
+		//NOTE:True when the format can be both ends of a linearly filtered blit, otherwise mips have to come from the CPU.
+		bool isLinearBlitSupported(VkFormat format) const;
+		//NOTE:Blits level 0 down the chain. Expects every level in TRANSFER_DST_OPTIMAL and leaves all of them SHADER_READ_ONLY_OPTIMAL.
+		void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels) const;
+
 		void createViews();
 		void createSwapchainViews();
 		void createDepthBufferBiews();
@@ -68,25 +110,57 @@ namespace app
 		void enableDebugReport();
 		void disableDebugReport();
 
+		//NOTE:Destroys GPU objects once every frame that may still reference them has completed.
+		void retireResource(std::function<void()> destroy);
+		void releaseRetiredResources(bool force = false);
+
 		//===================================================================================================
 
 		VkInstance m_instance = nullptr;
 
 		VkPhysicalDevice m_physicalDevice = nullptr;
 		VkPhysicalDeviceMemoryProperties m_physicalDeviceMemoryProperties{};
+		VkPhysicalDeviceProperties m_physicalDeviceProperties{};
+
+		VkPhysicalDeviceFeatures m_physicalDeviceFeatures{};
+		//NOTE:VK_EXT_graphics_pipeline_library with fast linking, m_pipelineRegistry links pipelines from libraries when set.
+		bool m_graphicsPipelineLibrarySupported = false;
 
 		VkDevice m_device = nullptr;
 		VkQueue m_deviceQueue = nullptr;
+		//NOTE:vkQueueSubmit needs external synchronization once loaders upload from worker threads.
+		mutable std::mutex m_queueMutex;
 		uint32_t m_graphicsQueueIndex = 0;
 
 		VkCommandPool m_commandPool = 0ull;
 
+		//NOTE:Pass to every vkCreate*Pipelines call.
+		static constexpr const char* PIPELINE_CACHE_FILE_NAME = "pipeline_cache.bin";
+		VkPipelineCache m_pipelineCache = 0ull;
+
+		//NOTE:Outlives m_pipelineRegistry, which builds every pipeline from its modules.
+		ShaderModuleCache m_shaderModuleCache;
+		//NOTE:Apps request pipelines by state through this, identical states share one VkPipeline.
+		PipelineRegistry m_pipelineRegistry;
+		FileWatcher m_shaderWatcher;
+		//NOTE:A single thread, so compiles of the same file finish in the order they were started.
+		std::unique_ptr<ThreadPool> m_shaderCompileThreadPool;
+		//NOTE:.spv files a compile in flight writes, their changes are picked up when the compile posts back.
+		std::multiset<std::filesystem::path> m_compilingShaders;
+
+		//NOTE:Filled by worker threads, drained by the render thread at the start of a frame.
+		std::mutex m_loadedResourcesMutex;
+		std::vector<std::function<void()>> m_loadedResources;
+
 		VkSurfaceKHR m_surface = 0ull;
 		VkSurfaceFormatKHR m_surfaceFormat{};
 		VkSurfaceCapabilitiesKHR m_surfaceCapabilities{};
 		VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		GLFWwindow* m_window = nullptr;
 		VkSwapchainKHR m_swapchain = 0ull;
 		VkExtent2D m_swapchainExtent{};
+		//NOTE:Set when present reports OUT_OF_DATE or SUBOPTIMAL, the next frame recreates first.
+		bool m_swapchainOutOfDate = false;
 
 		VkImage m_depthImage = 0ull;
 		VkDeviceMemory m_depthBufferMemory = 0ull;
@@ -109,6 +183,14 @@ namespace app
 		PFN_vkDestroyDebugReportCallbackEXT m_vkDestroyDebugReportCallbackEXT = nullptr;
 		VkDebugReportCallbackEXT m_debugReportCallback = 0ull;
 
+		PFN_vkGetPhysicalDeviceFeatures2KHR m_vkGetPhysicalDeviceFeatures2KHR = nullptr;
+		PFN_vkGetPhysicalDeviceProperties2KHR m_vkGetPhysicalDeviceProperties2KHR = nullptr;
+
 		uint32_t m_imageIndex = 0;
+
+		uint64_t m_frameNumber = 0;
+		uint64_t m_completedFrameNumber = 0;
+		std::vector<uint64_t> m_submittedFrameNumbers;
+		std::deque<std::pair<uint64_t, std::function<void()>>> m_retiredResources;
 	};
 }
\ No newline at end of file